@@ -5,11 +5,15 @@
 */
 #include <QCoreApplication>
 #include <QObject>
+#include <QSignalSpy>
 #include <QtTest>
+
 #include <memory>
 
 #include "config.h"
+#include "configdiff.h"
 #include "getconfigoperation.h"
+#include "mode.h"
 #include "output.h"
 
 using namespace Disman;
@@ -24,6 +28,12 @@ private Q_SLOTS:
     void test_load();
     void test_compare_simple_data();
     void test_compare_outputs();
+    void test_clone_modes();
+    void test_hash();
+    void test_mode_lookup();
+    void test_modes_fingerprint();
+    void test_set_outputs();
+    void test_diff();
 
 private:
     ConfigPtr load_config(std::string file_name);
@@ -127,6 +137,269 @@ void TestConfig::test_compare_outputs()
     QVERIFY(!config2->compare(config));
 }
 
+void TestConfig::test_clone_modes()
+{
+    auto config = load_config("multipleoutput.json");
+    QVERIFY(config);
+
+    // The first clone gets its own mode table. Its clone shares it until modes are handed out.
+    auto config2 = config->clone();
+    auto config3 = config2->clone();
+    QVERIFY(config2->compare(config3));
+
+    auto output2 = config2->outputs().at(1);
+    auto output3 = config3->outputs().at(1);
+
+    QCOMPARE(output2->auto_mode()->id(), output3->auto_mode()->id());
+    QCOMPARE(output2->geometry(), output3->geometry());
+
+    auto mode3 = output3->mode("3");
+    QVERIFY(mode3);
+    QVERIFY(mode3 != output2->mode("3"));
+    QVERIFY(output3->mode("3") == mode3);
+    QVERIFY(output3->modes().at("3") == mode3);
+
+    auto const size = mode3->size();
+    mode3->set_size(QSize(880, 440));
+    QCOMPARE(output2->mode("3")->size(), size);
+    QCOMPARE(config->outputs().at(1)->mode("3")->size(), size);
+    QCOMPARE(output3->mode("3")->size(), QSize(880, 440));
+
+    // Handed out modes are not shared with later clones.
+    auto output4 = output3->clone();
+    QVERIFY(output4->mode("3") != mode3);
+    mode3->set_size(size);
+    QCOMPARE(output4->mode("3")->size(), QSize(880, 440));
+
+    auto mode_clone = mode3->clone();
+    QCOMPARE(mode_clone->id(), mode3->id());
+    mode_clone->set_refresh(mode3->refresh() + 1);
+    QCOMPARE(mode_clone->refresh(), mode3->refresh() + 1);
+    QCOMPARE(output3->mode("3")->refresh(), mode3->refresh());
+}
+
+void TestConfig::test_hash()
+{
+    auto config = load_config("multipleoutput.json");
+    QVERIFY(config);
+
+    auto const empty_hash = config->fast_hash();
+    config->output(1)->set_hash("output-1");
+    config->output(2)->set_hash("output-2");
+    QVERIFY(config->fast_hash() != empty_hash);
+
+    auto const hash = config->hash();
+    auto const fast_hash = config->fast_hash();
+    QCOMPARE(hash.size(), 32);
+
+    auto config2 = config->clone();
+    QCOMPARE(config2->hash(), hash);
+    QCOMPARE(config2->fast_hash(), fast_hash);
+
+    // The hash is independent of output order.
+    auto output1 = config2->output(1);
+    auto output2 = config2->output(2);
+    auto const hash1 = output1->hash();
+    output1->set_hash_raw(output2->hash());
+    output2->set_hash_raw(hash1);
+    QCOMPARE(config2->hash(), hash);
+    QCOMPARE(config2->fast_hash(), fast_hash);
+
+    output1->set_hash("other-output");
+    QVERIFY(config2->hash() != hash);
+    QVERIFY(config2->fast_hash() != fast_hash);
+    QVERIFY(!config->compare(config2));
+
+    output1->set_hash_raw(output2->hash());
+    output2->set_hash_raw(hash1);
+    QCOMPARE(config2->hash(), hash);
+    QCOMPARE(config2->fast_hash(), fast_hash);
+
+    config2->remove_output(2);
+    QVERIFY(config2->hash() != hash);
+    QVERIFY(config2->fast_hash() != fast_hash);
+
+    config2->add_output(output2);
+    QCOMPARE(config2->hash(), hash);
+    QCOMPARE(config2->fast_hash(), fast_hash);
+
+    // Removed outputs do not invalidate the hash anymore.
+    config2->remove_output(2);
+    auto const removed_hash = config2->fast_hash();
+    output2->set_hash("other-output");
+    QCOMPARE(config2->fast_hash(), removed_hash);
+}
+
+void TestConfig::test_mode_lookup()
+{
+    auto config = load_config("multipleoutput.json");
+    QVERIFY(config);
+
+    auto output = config->output(2);
+    QVERIFY(output);
+
+    auto const modes = output->modes();
+    QVERIFY(!modes.empty());
+
+    for (auto const& [key, mode] : modes) {
+        auto found = output->mode(mode->size(), mode->refresh());
+        QVERIFY(found);
+        QCOMPARE(found->size(), mode->size());
+        QCOMPARE(found->refresh(), mode->refresh());
+    }
+    QVERIFY(!output->mode(QSize(123, 456), 60000));
+
+    // Changes to handed out modes are picked up by the lookup.
+    auto mode = modes.begin()->second;
+    auto const size = mode->size();
+    mode->set_size(QSize(123, 456));
+    QVERIFY(output->mode(QSize(123, 456), mode->refresh()) == mode);
+    QVERIFY(output->mode(size, mode->refresh()) != mode);
+
+    output->set_resolution(QSize(123, 456));
+    QVERIFY(output->set_refresh_rate(mode->refresh()));
+    QVERIFY(output->commanded_mode() == mode);
+    QVERIFY(!output->set_refresh_rate(mode->refresh() + 1));
+    QVERIFY(!output->commanded_mode());
+
+    // Clones have their own index.
+    auto clone = output->clone();
+    mode->set_size(size);
+    QVERIFY(clone->mode(QSize(123, 456), mode->refresh()));
+    QVERIFY(output->mode(size, mode->refresh()));
+}
+
+void TestConfig::test_modes_fingerprint()
+{
+    auto config = load_config("multipleoutput.json");
+    QVERIFY(config);
+
+    auto output1 = config->output(1);
+    auto output2 = config->output(2);
+    QVERIFY(output1);
+    QVERIFY(output2);
+
+    auto const fingerprint = output2->modes_fingerprint();
+    QVERIFY(fingerprint != output1->modes_fingerprint());
+
+    // Clones and outputs with copied modes have the same fingerprint.
+    auto clone = output2->clone();
+    QCOMPARE(clone->modes_fingerprint(), fingerprint);
+
+    Disman::ModeMap copied_modes;
+    for (auto const& [key, mode] : output2->modes()) {
+        copied_modes.insert({key, mode->clone()});
+    }
+    output1->set_modes(copied_modes);
+    QCOMPARE(output1->modes_fingerprint(), fingerprint);
+
+    // Changes to handed out modes are picked up.
+    auto mode = output2->modes().begin()->second;
+    mode->set_refresh(mode->refresh() + 1);
+    QVERIFY(output2->modes_fingerprint() != fingerprint);
+    QCOMPARE(clone->modes_fingerprint(), fingerprint);
+
+    mode->set_refresh(mode->refresh() - 1);
+    QCOMPARE(output2->modes_fingerprint(), fingerprint);
+
+    // Modes set on multiple outputs report their changes to all of them.
+    output1->set_modes(output2->modes());
+    QCOMPARE(output1->modes_fingerprint(), fingerprint);
+    mode->set_refresh(mode->refresh() + 1);
+    QVERIFY(output1->modes_fingerprint() != fingerprint);
+    QCOMPARE(output1->modes_fingerprint(), output2->modes_fingerprint());
+    QVERIFY(output1->mode(mode->size(), mode->refresh()) == mode);
+}
+
+void TestConfig::test_set_outputs()
+{
+    auto config = load_config("multipleoutput.json");
+    QVERIFY(config);
+    QCOMPARE(config->output_map().size(), 2);
+
+    auto outputs = config->outputs();
+    auto const primary = config->primary_output();
+
+    QSignalSpy added_spy(config.get(), &Config::output_added);
+    QSignalSpy removed_spy(config.get(), &Config::output_removed);
+    QSignalSpy primary_spy(config.get(), &Config::primary_output_changed);
+
+    // Setting the same outputs again does not touch them.
+    config->set_outputs(outputs);
+    QCOMPARE(added_spy.count(), 0);
+    QCOMPARE(removed_spy.count(), 0);
+    QCOMPARE(primary_spy.count(), 0);
+    QVERIFY(config->primary_output() == primary);
+
+    // Replaced outputs are removed and added again.
+    auto replacement = outputs.at(2)->clone();
+    outputs[2] = replacement;
+    config->set_outputs(outputs);
+    QCOMPARE(added_spy.count(), 1);
+    QCOMPARE(removed_spy.count(), 1);
+    QVERIFY(config->output(2) == replacement);
+    QVERIFY(config->output(1) == outputs.at(1));
+    QCOMPARE(config->output_map().size(), 2);
+
+    outputs.erase(1);
+    config->set_outputs(outputs);
+    QCOMPARE(added_spy.count(), 1);
+    QCOMPARE(removed_spy.count(), 2);
+    QCOMPARE(config->output_map().size(), 1);
+}
+
+void TestConfig::test_diff()
+{
+    auto config = load_config("multipleoutput.json");
+    QVERIFY(config);
+
+    auto config2 = config->clone();
+    QVERIFY(ConfigDiff(config, config2).empty());
+    QVERIFY(!ConfigDiff(config, nullptr).empty());
+    QCOMPARE(ConfigDiff(nullptr, config).added_outputs().size(), 2);
+
+    auto output = config2->output(1);
+    output->set_position(output->position() + QPointF(10, 0));
+    output->set_scale(2.);
+
+    auto diff = ConfigDiff(config, config2);
+    QVERIFY(!diff.empty());
+    QVERIFY(!diff.config_fields());
+    QCOMPARE(diff.changed_outputs().size(), 1);
+    QCOMPARE(diff.changed_fields(1), ConfigDiff::Field::Position | ConfigDiff::Field::Scale);
+    QCOMPARE(diff.changed_fields(2), ConfigDiff::Fields());
+    QVERIFY(diff.added_outputs().empty());
+    QVERIFY(diff.removed_outputs().empty());
+
+    config2->remove_output(2);
+    config2->set_cause(Config::Cause::interactive);
+
+    diff = ConfigDiff(config, config2);
+    QCOMPARE(diff.config_fields(), ConfigDiff::ConfigFields(ConfigDiff::ConfigField::Cause));
+    QCOMPARE(diff.removed_outputs(), std::vector<int>{2});
+    QVERIFY(diff.added_outputs().empty());
+
+    diff = ConfigDiff(config2, config);
+    QCOMPARE(diff.added_outputs(), std::vector<int>{2});
+
+    // Changed mode lists are detected.
+    auto modes = output->modes();
+    modes.erase(modes.begin());
+    output->set_modes(modes);
+    QVERIFY(ConfigDiff(config, config2).changed_fields(1).testFlag(ConfigDiff::Field::Modes));
+
+    // Applying a config only updates changed outputs.
+    auto config3 = config->clone();
+    config3->output(1)->set_scale(2.);
+
+    QSignalSpy updated_spy1(config->output(1).get(), &Output::updated);
+    QSignalSpy updated_spy2(config->output(2).get(), &Output::updated);
+    config->apply(config3);
+    QCOMPARE(updated_spy1.count(), 1);
+    QCOMPARE(updated_spy2.count(), 0);
+    QCOMPARE(config->output(1)->scale(), 2.);
+}
+
 QTEST_GUILESS_MAIN(TestConfig)
 
 #include "config.moc"
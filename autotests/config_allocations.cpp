@@ -0,0 +1,133 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include <QCoreApplication>
+#include <QObject>
+#include <QtTest>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#include "backend.h"
+#include "backendmanager_p.h"
+#include "config.h"
+#include "getconfigoperation.h"
+#include "mode.h"
+#include "output.h"
+
+using namespace Disman;
+
+namespace
+{
+std::atomic<uint64_t> s_allocations{0};
+}
+
+// Counts all allocations of the test process. This is the only test in this binary, so no other
+// tests are affected by the replaced operators.
+void* operator new(std::size_t size)
+{
+    ++s_allocations;
+    if (auto ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+class TestConfigAllocations : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void test_accessor_allocations();
+
+    void bench_config_allocations();
+
+private:
+    ConfigPtr load_config(std::string file_name);
+};
+
+void TestConfigAllocations::initTestCase()
+{
+    qputenv("DISMAN_LOGGING", "false");
+    qputenv("DISMAN_IN_PROCESS", "1");
+    qputenv("DISMAN_BACKEND", "fake");
+}
+
+ConfigPtr TestConfigAllocations::load_config(std::string file_name)
+{
+    auto test_data = std::string("TEST_DATA=") + std::string(TEST_DATA) + file_name;
+    qputenv("DISMAN_BACKEND_ARGS", test_data.c_str());
+
+    auto op = new GetConfigOperation();
+    if (!op->exec()) {
+        qDebug() << "GetConfigOperation::exec failed.";
+        return nullptr;
+    }
+    return op->config();
+}
+
+void TestConfigAllocations::test_accessor_allocations()
+{
+    auto config = load_config("multipleoutput.json");
+    QVERIFY(config);
+    auto clone = config->clone();
+
+    auto read_modes = [](ConfigPtr const& config) {
+        int count = 0;
+        for (auto const& [id, output] : config->output_map()) {
+            for (auto const& [key, mode] : output->mode_map()) {
+                count += mode->size().isValid();
+            }
+        }
+        return count;
+    };
+
+    // Reading through the reference accessors neither copies the maps nor the shared mode tables.
+    auto allocations = s_allocations.load();
+    auto const count = read_modes(config);
+    QCOMPARE(s_allocations.load(), allocations);
+    QCOMPARE(read_modes(clone), count);
+    QCOMPARE(s_allocations.load(), allocations);
+
+    int copied_count = 0;
+    for (auto const& [id, output] : clone->outputs()) {
+        for (auto const& [key, mode] : output->modes()) {
+            copied_count += mode->size().isValid();
+        }
+    }
+    QCOMPARE(copied_count, count);
+    QVERIFY(s_allocations.load() > allocations);
+}
+
+void TestConfigAllocations::bench_config_allocations()
+{
+    QVERIFY(load_config("multipleoutput.json"));
+
+    auto backend = BackendManager::instance()->load_backend_in_process(QString());
+    QVERIFY(backend);
+
+    auto const allocations = s_allocations.load();
+    auto config = backend->config();
+    QVERIFY(config);
+    QTest::setBenchmarkResult(s_allocations.load() - allocations, QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(TestConfigAllocations)
+
+#include "config_allocations.moc"
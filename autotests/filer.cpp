@@ -0,0 +1,522 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QObject>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "config.h"
+#include "device.h"
+#include "filer.h"
+#include "filer_cache.h"
+#include "filer_controller.h"
+#include "filer_gc.h"
+#include "filer_helpers.h"
+#include "filer_store.h"
+#include "mode.h"
+#include "output.h"
+
+using namespace Disman;
+
+class TestFiler : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void test_shadow_cache();
+    void test_garbage_collection();
+    void test_read_resolved();
+    void test_usage();
+
+    void test_store();
+    void test_store_torn_record();
+    void test_store_unknown_header();
+    void test_store_compaction();
+    void test_store_import();
+
+    void bench_read_json();
+    void bench_read_shadow();
+
+private:
+    QFileInfo write_control_file();
+    ConfigPtr create_config(std::string const& mode_prefix, int mode_count);
+};
+
+void TestFiler::initTestCase()
+{
+    qputenv("DISMAN_LOGGING", "false");
+    QStandardPaths::setTestModeEnabled(true);
+    cleanup();
+}
+
+void TestFiler::cleanup()
+{
+    QDir(Filer_helpers::control_dir_path()).removeRecursively();
+    QDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+         + QStringLiteral("/disman"))
+        .removeRecursively();
+}
+
+QFileInfo TestFiler::write_control_file()
+{
+    QVariantList outputs;
+    for (int index = 0; index < 8; index++) {
+        QVariantMap pos;
+        pos[QStringLiteral("x")] = index * 1920;
+        pos[QStringLiteral("y")] = 0;
+
+        QVariantMap resolution;
+        resolution[QStringLiteral("width")] = 1920;
+        resolution[QStringLiteral("height")] = 1080;
+
+        QVariantMap mode;
+        mode[QStringLiteral("refresh")] = 60000;
+        mode[QStringLiteral("resolution")] = resolution;
+
+        QVariantMap output;
+        output[QStringLiteral("id")] = QStringLiteral("%1").arg(index, 32, 16, QLatin1Char('0'));
+        output[QStringLiteral("enabled")] = true;
+        output[QStringLiteral("retention")] = 1;
+        output[QStringLiteral("pos")] = pos;
+        output[QStringLiteral("mode")] = mode;
+        output[QStringLiteral("scale")] = 1.5;
+        output[QStringLiteral("replicate")] = QString();
+        outputs << output;
+    }
+
+    QVariantMap info;
+    info[QStringLiteral("outputs")] = outputs;
+
+    QFileInfo const file_info(Filer_helpers::control_dir_path()
+                              + QStringLiteral("configs/0123456789abcdef.json"));
+    if (!Filer_helpers::write_file(info, file_info)) {
+        return QFileInfo();
+    }
+    return file_info;
+}
+
+ConfigPtr TestFiler::create_config(std::string const& mode_prefix, int mode_count)
+{
+    ConfigPtr config(new Config);
+    config->set_supported_features(Config::Feature::Writable | Config::Feature::PerOutputScaling);
+
+    ModeMap modes;
+    for (int index = 0; index < mode_count; index++) {
+        ModePtr mode(new Mode);
+        mode->set_id(mode_prefix + std::to_string(index));
+        mode->set_size(QSize(1920 - index * 640, 1080 - index * 360));
+        mode->set_refresh(60000);
+        modes.insert({mode->id(), mode});
+    }
+
+    OutputPtr output(new Output);
+    output->set_id(1);
+    output->set_name("DP-1");
+    output->set_hash("resolved-output");
+    output->set_modes(modes);
+    output->set_preferred_modes({mode_prefix + "0"});
+    output->set_mode(modes.at(mode_prefix + "0"));
+    output->set_enabled(true);
+
+    config->set_outputs({{output->id(), output}});
+    return config;
+}
+
+void TestFiler::test_shadow_cache()
+{
+    auto const file_info = write_control_file();
+    QVERIFY(file_info.exists());
+
+    auto& cache = Filer_cache::instance();
+    auto const shadow = Filer_cache::shadow_path(file_info.filePath());
+    QVERIFY(!shadow.isEmpty());
+    QVERIFY(!QFile::exists(shadow));
+
+    // The first read parses the JSON file and creates the shadow copy.
+    QVariantMap json_info;
+    QVERIFY(cache.read(file_info, json_info));
+    QCOMPARE(json_info[QStringLiteral("outputs")].toList().size(), 8);
+    QVERIFY(QFile::exists(shadow));
+
+    // Without the in-memory entry the shadow copy is read.
+    cache.invalidate(file_info.filePath());
+    QVariantMap shadow_info;
+    QVERIFY(cache.read(file_info, shadow_info));
+    QCOMPARE(shadow_info, json_info);
+
+    // Files outside of the control directory get no shadow copy.
+    QVERIFY(Filer_cache::shadow_path(QStringLiteral("/tmp/control.json")).isEmpty());
+
+    // Edits of the JSON file take precedence.
+    QFile file(file_info.filePath());
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(R"({"edited": true})");
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(10),
+                             QFileDevice::FileModificationTime));
+    file.close();
+
+    cache.invalidate(file_info.filePath());
+    QVariantMap edited_info;
+    QVERIFY(cache.read(file_info, edited_info));
+    QCOMPARE(edited_info[QStringLiteral("edited")].toBool(), true);
+    QVERIFY(!edited_info.contains(QStringLiteral("outputs")));
+}
+
+void TestFiler::test_garbage_collection()
+{
+    auto const dir_path = Filer_helpers::control_dir_path();
+    auto const now = QDateTime::currentDateTimeUtc();
+
+    auto write = [](QString const& path) {
+        QVariantMap info;
+        info[QStringLiteral("scale")] = 1.;
+        return Filer_helpers::write_file(info, QFileInfo(path));
+    };
+
+    auto const recent = dir_path + QStringLiteral("configs/recent.json");
+    auto const older = dir_path + QStringLiteral("configs/older.json");
+    auto const expired = dir_path + QStringLiteral("configs/expired.json");
+    auto const untracked = dir_path + QStringLiteral("outputs/untracked.json");
+    auto const lid = dir_path + QStringLiteral("configs/closed-open-lid.json");
+
+    for (auto const& path : {recent, older, expired, untracked, lid}) {
+        QVERIFY(write(path));
+    }
+
+    // Files without a usage record count as used when they were modified.
+    QFile untracked_file(untracked);
+    QVERIFY(untracked_file.open(QIODevice::ReadWrite));
+    QVERIFY(untracked_file.setFileTime(now.addDays(-400), QFileDevice::FileModificationTime));
+    untracked_file.close();
+
+    QVariantMap usage;
+    Filer_gc::touch(usage, {recent}, now);
+    Filer_gc::touch(usage, {older}, now.addDays(-10));
+    Filer_gc::touch(usage, {expired}, now.addDays(-400));
+    Filer_gc::touch(usage, {lid}, now.addDays(-400));
+    QVERIFY(Filer_helpers::write_file(usage, QFileInfo(Filer_gc::usage_path())));
+
+    Filer_gc::Policy policy;
+    policy.max_count = 0;
+    policy.max_age = 365;
+
+    auto result = Filer_gc::collect(policy, now);
+    QCOMPARE(result.removed.size(), 2);
+    QVERIFY(result.removed.contains(expired));
+    QVERIFY(result.removed.contains(untracked));
+    QVERIFY(result.reclaimed_bytes > 0);
+    QCOMPARE(result.kept, 3);
+    QVERIFY(QFile::exists(recent));
+    QVERIFY(QFile::exists(older));
+    QVERIFY(QFile::exists(lid));
+    QVERIFY(!QFile::exists(expired));
+    QVERIFY(!QFile::exists(untracked));
+
+    // The count limit removes the least recently used files first.
+    policy.max_count = 1;
+    result = Filer_gc::collect(policy, now);
+    QCOMPARE(result.removed, QStringList{older});
+    QCOMPARE(result.kept, 2);
+    QVERIFY(QFile::exists(recent));
+    QVERIFY(QFile::exists(lid));
+
+    // Records of removed files are dropped from the usage file.
+    usage.clear();
+    QVERIFY(Filer_helpers::read_file(QFileInfo(Filer_gc::usage_path()), usage));
+    QCOMPARE(usage.keys(),
+             QStringList({QStringLiteral("configs/closed-open-lid.json"),
+                          QStringLiteral("configs/recent.json")}));
+}
+
+void TestFiler::test_read_resolved()
+{
+    Device device;
+    Filer_controller controller(&device);
+
+    auto config = create_config("a", 2);
+    auto output = config->output(1);
+    output->set_auto_resolution(false);
+    output->set_auto_refresh_rate(false);
+    output->set_mode(output->mode("a1"));
+    output->set_position(QPointF(100, 0));
+    output->set_scale(1.5);
+    QVERIFY(controller.write(config));
+    controller.flush();
+
+    // After replugging the windowing system announces the same modes with other ids.
+    auto current = create_config("b", 2);
+    QVERIFY(controller.read_resolved(current));
+
+    auto const resolved = current->output(1);
+    QVERIFY(!resolved->auto_resolution());
+    QCOMPARE(resolved->position(), QPointF(100, 0));
+    QCOMPARE(resolved->scale(), 1.5);
+    QVERIFY(resolved->commanded_mode());
+    QCOMPARE(resolved->commanded_mode()->id(), std::string("b1"));
+    QCOMPARE(resolved->mode_map().size(), 2);
+    QVERIFY(resolved->mode("a1") == nullptr);
+
+    // The resolved config is not used when its mode is not available anymore.
+    QVERIFY(controller.write(config));
+    controller.flush();
+
+    auto reduced = create_config("c", 1);
+    QVERIFY(!controller.read_resolved(reduced));
+    QCOMPARE(reduced->output(1)->commanded_mode()->id(), std::string("c0"));
+}
+
+void TestFiler::test_usage()
+{
+    auto const usage_path = Filer_gc::usage_path();
+    auto config = create_config("a", 1);
+
+    {
+        Device device;
+        Filer_controller controller(&device);
+        QVERIFY(controller.write(config));
+        controller.flush();
+
+        // Uses are only recorded in memory meanwhile.
+        QVERIFY(!QFile::exists(usage_path));
+    }
+
+    QVariantMap usage;
+    QVERIFY(Filer_helpers::read_file(QFileInfo(usage_path), usage));
+
+    QDir const dir(Filer_helpers::control_dir_path());
+    for (auto const& path : Filer::file_paths(config)) {
+        QVERIFY(usage.contains(dir.relativeFilePath(path)));
+    }
+}
+
+void TestFiler::test_store()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto const dir_path = dir.path() + QStringLiteral("/");
+    auto const config_path = dir_path + QStringLiteral("configs/config.json");
+    auto const output_path = dir_path + QStringLiteral("outputs/output.json");
+    auto const renamed_path = dir_path + QStringLiteral("outputs/renamed.json");
+
+    QVariantMap config_info;
+    config_info[QStringLiteral("scale")] = 1.5;
+    QVariantMap output_info;
+    output_info[QStringLiteral("enabled")] = true;
+
+    {
+        auto store = Filer_store::open(dir_path);
+        QCOMPARE(store->revision(config_path), uint64_t{0});
+        QVERIFY(store->write(config_path, config_info));
+        auto const revision = store->revision(config_path);
+        QVERIFY(revision > 0);
+
+        // Writing the same content does not change the file.
+        QVERIFY(store->write(config_path, config_info));
+        QCOMPARE(store->revision(config_path), revision);
+
+        QVERIFY(store->write(output_path, output_info));
+        QVERIFY(store->rename(output_path, renamed_path));
+        QVERIFY(store->revision(output_path) > revision);
+        QVERIFY(store->revision(renamed_path) > revision);
+        QVERIFY(!store->rename(output_path, renamed_path));
+        QVERIFY(!store->contains(output_path));
+    }
+
+    // No control files are written besides the log.
+    QVERIFY(QFile::exists(dir_path + QStringLiteral("store.log")));
+    QVERIFY(!QFile::exists(config_path));
+    QVERIFY(!QFile::exists(renamed_path));
+
+    auto store = Filer_store::open(dir_path);
+    QVariantMap info;
+    QVERIFY(store->read(config_path, info));
+    QCOMPARE(info, config_info);
+    QVERIFY(store->read(renamed_path, info));
+    QCOMPARE(info, output_info);
+    QVERIFY(!store->contains(output_path));
+    QCOMPARE(store->paths(dir_path + QStringLiteral("outputs")), QStringList{renamed_path});
+
+    // Empty content removes the entry.
+    QCOMPARE(store->revision(config_path), uint64_t{0});
+    QVERIFY(store->write(config_path, QVariantMap()));
+    QVERIFY(store->revision(config_path) > 0);
+    QVERIFY(!Filer_store::open(dir_path)->contains(config_path));
+}
+
+void TestFiler::test_store_torn_record()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto const dir_path = dir.path() + QStringLiteral("/");
+    auto const log_path = dir_path + QStringLiteral("store.log");
+    auto const first_path = dir_path + QStringLiteral("configs/first.json");
+    auto const second_path = dir_path + QStringLiteral("configs/second.json");
+
+    QVariantMap info;
+    info[QStringLiteral("scale")] = 2.;
+
+    qint64 intact_size;
+    {
+        auto store = Filer_store::open(dir_path);
+        QVERIFY(store->write(first_path, info));
+        intact_size = store->size();
+        QVERIFY(store->write(second_path, info));
+    }
+
+    // Cut off the last record as if the process was stopped while appending it.
+    QFile file(log_path);
+    QVERIFY(file.resize(file.size() - 3));
+
+    auto store = Filer_store::open(dir_path);
+    QVERIFY(store->contains(first_path));
+    QVERIFY(!store->contains(second_path));
+    QCOMPARE(QFileInfo(log_path).size(), intact_size);
+
+    // Later records are appended behind the intact ones.
+    QVERIFY(store->write(second_path, info));
+    QVERIFY(Filer_store::open(dir_path)->contains(second_path));
+}
+
+void TestFiler::test_store_unknown_header()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto const dir_path = dir.path() + QStringLiteral("/");
+    auto const log_path = dir_path + QStringLiteral("store.log");
+
+    QFile file(log_path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("XXXX-not-a-control-store");
+    file.close();
+
+    // The log is moved aside and a new one is started.
+    auto store = Filer_store::open(dir_path);
+    QVERIFY(store->paths(dir_path + QStringLiteral("configs")).isEmpty());
+    QVERIFY(QFile::exists(log_path + QStringLiteral(".unknown")));
+
+    auto const path = dir_path + QStringLiteral("configs/config.json");
+    QVariantMap info;
+    info[QStringLiteral("scale")] = 1.;
+    QVERIFY(store->write(path, info));
+    QVERIFY(Filer_store::open(dir_path)->contains(path));
+}
+
+void TestFiler::test_store_compaction()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto const dir_path = dir.path() + QStringLiteral("/");
+    auto const path = dir_path + QStringLiteral("configs/config.json");
+
+    auto info_at = [](int index) {
+        QVariantMap info;
+        info[QStringLiteral("index")] = QStringLiteral("%1").arg(index, 4, 10, QLatin1Char('0'));
+        return info;
+    };
+
+    auto store = Filer_store::open(dir_path);
+    QVERIFY(store->write(path, info_at(0)));
+    auto const single_size = store->size();
+    auto const record_size = single_size - 8;
+
+    // Overwriting the same entry grows the log only up to a bound before it is compacted.
+    qint64 max_size = 0;
+    for (int index = 1; index < 1000; index++) {
+        QVERIFY(store->write(path, info_at(index)));
+        max_size = std::max(max_size, store->size());
+    }
+    QVERIFY(max_size > single_size);
+    QVERIFY(max_size < single_size + 100 * record_size);
+
+    QVERIFY(store->compact());
+    QCOMPARE(store->size(), single_size);
+
+    QVariantMap info;
+    QVERIFY(Filer_store::open(dir_path)->read(path, info));
+    QCOMPARE(info, info_at(999));
+}
+
+void TestFiler::test_store_import()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto const dir_path = dir.path() + QStringLiteral("/");
+    auto const config_path = dir_path + QStringLiteral("configs/config.json");
+    auto const output_path = dir_path + QStringLiteral("outputs/output.json");
+
+    QVariantMap info;
+    info[QStringLiteral("scale")] = 1.25;
+    QVERIFY(Filer_helpers::write_file(info, QFileInfo(config_path)));
+    QVERIFY(Filer_helpers::write_file(info, QFileInfo(output_path)));
+
+    {
+        auto store = Filer_store::open(dir_path);
+        QVERIFY(store->contains(config_path));
+        QVERIFY(store->contains(output_path));
+    }
+
+    // The files are left in place but not imported a second time.
+    QVERIFY(QFile::exists(config_path));
+    QVERIFY(QFile::remove(output_path));
+    auto const new_path = dir_path + QStringLiteral("configs/new.json");
+    QVERIFY(Filer_helpers::write_file(info, QFileInfo(new_path)));
+
+    auto store = Filer_store::open(dir_path);
+    QVariantMap imported;
+    QVERIFY(store->read(config_path, imported));
+    QCOMPARE(imported, info);
+    QVERIFY(store->contains(output_path));
+    QVERIFY(!store->contains(new_path));
+
+    // Existing entries are renamed in the store only.
+    auto const renamed_path = dir_path + QStringLiteral("configs/renamed.json");
+    QVERIFY(store->rename(config_path, renamed_path));
+    QVERIFY(QFile::exists(config_path));
+    QVERIFY(!QFile::exists(renamed_path));
+    QVERIFY(Filer_store::open(dir_path)->contains(renamed_path));
+}
+
+void TestFiler::bench_read_json()
+{
+    auto const file_info = write_control_file();
+    QVERIFY(file_info.exists());
+
+    QBENCHMARK
+    {
+        QFile file(file_info.filePath());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        auto const info = QJsonDocument::fromJson(file.readAll()).toVariant().toMap();
+        QVERIFY(!info.isEmpty());
+    }
+}
+
+void TestFiler::bench_read_shadow()
+{
+    auto const file_info = write_control_file();
+    QVERIFY(file_info.exists());
+
+    auto& cache = Filer_cache::instance();
+    QVariantMap info;
+    QVERIFY(cache.read(file_info, info));
+
+    QBENCHMARK
+    {
+        cache.invalidate(file_info.filePath());
+        QVERIFY(cache.read(file_info, info));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestFiler)
+
+#include "filer.moc"
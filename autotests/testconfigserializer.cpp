@@ -16,10 +16,14 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  *
  */
+#include <QJsonDocument>
 #include <QObject>
 #include <QtTest>
 
+#include "config.h"
+#include "configdiff.h"
 #include "configserializer_p.h"
+#include "configsnapshot_p.h"
 #include "mode.h"
 #include "output.h"
 #include "screen.h"
@@ -184,6 +188,251 @@ private Q_SLOTS:
 
         QCOMPARE(obj2[QStringLiteral("refresh")].toDouble(), output->commanded_mode()->refresh());
     }
+
+    void testSerializeConfigDelta()
+    {
+        auto create_output = [](int id) {
+            Disman::ModePtr mode(new Disman::Mode);
+            mode->set_id("1");
+            mode->set_size(QSize(800, 600));
+            mode->set_refresh(60);
+
+            Disman::OutputPtr output(new Disman::Output);
+            output->set_id(id);
+            output->set_name("DP-" + std::to_string(id));
+            output->set_modes({{mode->id(), mode}});
+            output->set_enabled(true);
+            return output;
+        };
+
+        Disman::ConfigPtr before(new Disman::Config);
+        before->add_output(create_output(1));
+        before->add_output(create_output(2));
+
+        auto after = before->clone();
+        after->output(1)->set_position(QPointF(800, 0));
+        after->remove_output(2);
+        after->add_output(create_output(3));
+        after->set_primary_output(after->output(3));
+
+        Disman::ConfigDiff const diff(before, after);
+        auto const obj = Disman::ConfigSerializer::serialize_config_delta(after, diff);
+
+        QVERIFY(!obj.contains(QLatin1String("valid")));
+        QVERIFY(!obj.contains(QLatin1String("cause")));
+        QVERIFY(!obj.contains(QLatin1String("tablet_mode_engaged")));
+        QCOMPARE(obj[QLatin1String("primary-output")].toInt(), 3);
+
+        auto const outputs = obj[QLatin1String("outputs")].toArray();
+        QCOMPARE(outputs.size(), 1);
+        auto const added = outputs[0].toObject();
+        QCOMPARE(added[QLatin1String("id")].toInt(), 3);
+        QVERIFY(added.contains(QLatin1String("modes")));
+
+        auto const changed_outputs = obj[QLatin1String("changed_outputs")].toArray();
+        QCOMPARE(changed_outputs.size(), 1);
+        auto const changed = changed_outputs[0].toObject();
+        QCOMPARE(changed.size(), 2);
+        QCOMPARE(changed[QLatin1String("id")].toInt(), 1);
+        auto const pos = changed[QLatin1String("position")].toObject();
+        QCOMPARE(pos[QLatin1String("x")].toInt(), 800);
+
+        auto const removed = obj[QLatin1String("removed_outputs")].toArray();
+        QCOMPARE(removed.size(), 1);
+        QCOMPARE(removed[0].toInt(), 2);
+
+        auto const empty_diff = Disman::ConfigDiff(after, after->clone());
+        QVERIFY(empty_diff.empty());
+        QVERIFY(Disman::ConfigSerializer::serialize_config_delta(after, empty_diff).isEmpty());
+    }
+
+    void testConfigDeltaValid()
+    {
+        Disman::ConfigPtr before(new Disman::Config);
+        auto after = before->clone();
+        after->set_valid(false);
+
+        Disman::ConfigDiff const diff(before, after);
+        QVERIFY(diff.config_fields().testFlag(Disman::ConfigDiff::ConfigField::Valid));
+
+        auto const obj = Disman::ConfigSerializer::serialize_config_delta(after, diff);
+        QCOMPARE(obj.size(), 1);
+        QCOMPARE(obj[QLatin1String("valid")].toBool(), false);
+
+        auto config = before->clone();
+        QVERIFY(config->valid());
+        QVERIFY(Disman::ConfigSerializer::apply_config_delta(config, obj.toVariantMap()));
+        QVERIFY(!config->valid());
+        QVERIFY(Disman::ConfigDiff(config, after).empty());
+    }
+
+    void testSerializeConfigBinary()
+    {
+        auto const config = create_config();
+
+        auto const data = Disman::ConfigSerializer::serialize_config_binary(config);
+        QVERIFY(!data.isEmpty());
+
+        auto const deserialized = Disman::ConfigSerializer::deserialize_config_binary(data);
+        QVERIFY(deserialized);
+        QVERIFY(Disman::ConfigDiff(config, deserialized).empty());
+        QCOMPARE(deserialized->primary_output()->id(), config->primary_output()->id());
+        QCOMPARE(deserialized->screen()->max_size(), config->screen()->max_size());
+
+        auto const global = deserialized->output(2)->global_data();
+        QVERIFY(global.valid);
+        QCOMPARE(global.resolution, QSize(1920, 1080));
+        QCOMPARE(global.scale, 1.5);
+
+        // The DBus map repeats every key as string and adds type signatures and padding, so the
+        // compact JSON size is a lower bound for it.
+        auto const json = QJsonDocument(Disman::ConfigSerializer::serialize_config(config))
+                              .toJson(QJsonDocument::Compact);
+        QVERIFY(data.size() < json.size() / 2);
+
+        QVERIFY(!Disman::ConfigSerializer::deserialize_config_binary(QByteArray("garbage")));
+        QVERIFY(!Disman::ConfigSerializer::deserialize_config_binary(json));
+    }
+
+    void testConfigSnapshotSharedMemory()
+    {
+#ifndef Q_OS_LINUX
+        QSKIP("Shared memory config snapshots are only supported on Linux.");
+#endif
+        auto const config = create_config();
+
+        Disman::ConfigSnapshotWriter writer;
+        QCOMPARE(writer.fd(), -1);
+        QVERIFY(writer.publish(config, 5));
+        QVERIFY(writer.fd() >= 0);
+
+        Disman::ConfigSnapshotReader reader;
+        QVERIFY(reader.map(writer.fd()));
+        QVERIFY(!reader.retired());
+
+        uint64_t generation = 0;
+        auto snapshot = reader.read(generation);
+        QVERIFY(snapshot);
+        QCOMPARE(generation, uint64_t(5));
+        QVERIFY(Disman::ConfigDiff(config, snapshot).empty());
+
+        // Updates are visible through the existing mapping.
+        config->output(2)->set_position(QPointF(100, 200));
+        QVERIFY(writer.publish(config, 6));
+        snapshot = reader.read(generation);
+        QVERIFY(snapshot);
+        QCOMPARE(generation, uint64_t(6));
+        QCOMPARE(snapshot->output(2)->position(), QPointF(100, 200));
+
+        // The generation is only current while no change is pending.
+        QVERIFY(reader.current_generation(generation));
+        QCOMPARE(generation, uint64_t(6));
+        writer.set_pending(true);
+        QVERIFY(!reader.current_generation(generation));
+        writer.set_pending(false);
+        QVERIFY(reader.current_generation(generation));
+        writer.set_pending(true);
+        QVERIFY(writer.publish(config, 7));
+        QVERIFY(reader.current_generation(generation));
+        QCOMPARE(generation, uint64_t(7));
+
+        // A region abandoned by its writer stays readable but is marked as such.
+        Disman::ConfigSnapshotReader stale_reader;
+        {
+            Disman::ConfigSnapshotWriter stale_writer;
+            QVERIFY(stale_writer.publish(config, 1));
+            QVERIFY(stale_reader.map(stale_writer.fd()));
+        }
+        QVERIFY(stale_reader.retired());
+        QVERIFY(stale_reader.read(generation));
+        QCOMPARE(generation, uint64_t(1));
+        QVERIFY(!stale_reader.current_generation(generation));
+
+        QVERIFY(!reader.map(-1));
+        QVERIFY(!reader.mapped());
+        QVERIFY(!reader.read(generation));
+    }
+
+    void benchSerializeConfigMap()
+    {
+        auto const config = create_config();
+        QBENCHMARK
+        {
+            auto const map = Disman::ConfigSerializer::serialize_config(config).toVariantMap();
+            QVERIFY(!map.isEmpty());
+        }
+    }
+
+    void benchSerializeConfigBinary()
+    {
+        auto const config = create_config();
+        QBENCHMARK
+        {
+            auto const data = Disman::ConfigSerializer::serialize_config_binary(config);
+            QVERIFY(!data.isEmpty());
+        }
+    }
+
+    void benchDeserializeConfigBinary()
+    {
+        auto const data = Disman::ConfigSerializer::serialize_config_binary(create_config());
+        QBENCHMARK
+        {
+            auto const config = Disman::ConfigSerializer::deserialize_config_binary(data);
+            QVERIFY(config);
+        }
+    }
+
+private:
+    Disman::ConfigPtr create_config()
+    {
+        Disman::ConfigPtr config(new Disman::Config(Disman::Config::Cause::file));
+
+        Disman::ScreenPtr screen(new Disman::Screen);
+        screen->set_id(1);
+        screen->set_max_size(QSize(8192, 8192));
+        screen->set_current_size(QSize(3840, 1080));
+        config->setScreen(screen);
+
+        for (int id = 1; id <= 3; id++) {
+            Disman::ModeMap modes;
+            for (int index = 0; index < 30; index++) {
+                Disman::ModePtr mode(new Disman::Mode);
+                mode->set_id(std::to_string(index));
+                mode->set_name("mode-" + std::to_string(index));
+                mode->set_size(QSize(1920 - index * 32, 1080 - index * 18));
+                mode->set_refresh(60000 - (index % 3) * 10000);
+                modes.insert({mode->id(), mode});
+            }
+
+            Disman::OutputPtr output(new Disman::Output);
+            output->set_id(id);
+            output->set_name("DP-" + std::to_string(id));
+            output->set_description("Vendor Model " + std::to_string(id));
+            output->set_hash("output-" + std::to_string(id));
+            output->set_modes(modes);
+            output->set_preferred_modes({"0"});
+            output->set_mode(modes.at("0"));
+            output->set_position(QPointF((id - 1) * 1920, 0));
+            output->set_physical_size(QSize(530, 300));
+            output->set_enabled(id != 3);
+
+            if (id == 2) {
+                Disman::Output::GlobalData global;
+                global.resolution = QSize(1920, 1080);
+                global.refresh = 60000;
+                global.rotation = Disman::Output::None;
+                global.scale = 1.5;
+                global.valid = true;
+                output->set_global_data(global);
+            }
+
+            config->add_output(output);
+        }
+
+        config->set_primary_output(config->output(1));
+        return config;
+    }
 };
 
 QTEST_MAIN(TestConfigSerializer)
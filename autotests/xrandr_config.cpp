@@ -0,0 +1,182 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include <QGuiApplication>
+#include <QObject>
+#include <QStandardPaths>
+#include <QtTest>
+
+#include "xcbwrapper.h"
+#include "xrandr.h"
+#include "xrandrconfig.h"
+#include "xrandrcrtc.h"
+#include "xrandroutput.h"
+
+#include <memory>
+
+class TestXRandRConfig : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void test_round_trips();
+    void test_atoms();
+    void test_notify();
+    void test_crtc_rollback();
+
+    void bench_round_trips();
+    void bench_construct();
+
+private:
+    std::unique_ptr<XRandR> m_backend;
+};
+
+void TestXRandRConfig::initTestCase()
+{
+    qputenv("DISMAN_LOGGING", "false");
+    QStandardPaths::setTestModeEnabled(true);
+
+    if (QGuiApplication::platformName() != QLatin1String("xcb")) {
+        QSKIP("Test requires an X server, for example Xvfb.");
+    }
+
+    m_backend.reset(new XRandR);
+    if (!m_backend->valid()) {
+        QSKIP("XRandR extension is not available.");
+    }
+}
+
+void TestXRandRConfig::test_round_trips()
+{
+    auto round_trips = XCB::roundTrips();
+    XRandRConfig config;
+    auto const batched = XCB::roundTrips() - round_trips;
+
+    QVERIFY(!config.outputs().empty());
+
+    // As when outputs are hotplugged all requests of an output are sent one after the other.
+    round_trips = XCB::roundTrips();
+    for (auto const& [id, output] : config.outputs()) {
+        new XRandROutput(id, &config);
+    }
+    auto const sequential = XCB::roundTrips() - round_trips;
+
+    QVERIFY(batched < sequential);
+}
+
+void TestXRandRConfig::test_atoms()
+{
+    // Atoms are interned when the backend is created.
+    auto const round_trips = XCB::roundTrips();
+    auto const& atoms = XCB::atoms();
+    QCOMPARE(XCB::roundTrips(), round_trips);
+
+    QVERIFY(atoms.edid != XCB_ATOM_NONE);
+    QVERIFY(atoms.hotplugModeUpdate != XCB_ATOM_NONE);
+    QCOMPARE(atoms.edid, XCB::InternAtom(false, 4, "EDID")->atom);
+
+    // EDIDs fetched with the config are the same as when fetched for single outputs.
+    XRandRConfig config;
+    for (auto const& [id, output] : config.outputs()) {
+        QCOMPARE(output->edid(), XRandR::outputEdid(id));
+    }
+}
+
+void TestXRandRConfig::test_notify()
+{
+    XRandRConfig config;
+    QVERIFY(!config.outputs().empty());
+
+    auto output = config.outputs().begin()->second;
+    auto const crtc = output->crtc() ? output->crtc()->crtc() : XCB_NONE;
+    auto const mode = output->crtc() ? output->crtc()->mode() : XCB_NONE;
+    auto const connection = output->isConnected() ? XCB_RANDR_CONNECTION_CONNECTED
+                                                  : XCB_RANDR_CONNECTION_DISCONNECTED;
+
+    XCB::ScopedPointer<xcb_randr_get_screen_resources_reply_t> resources(XRandR::screenResources());
+    QVERIFY(resources);
+
+    // With an unchanged server configuration the notification contains everything.
+    auto const round_trips = XCB::roundTrips();
+    output->updateFromNotify(crtc, mode, connection, resources->config_timestamp);
+    QCOMPARE(XCB::roundTrips(), round_trips);
+
+    // Otherwise the output is queried again.
+    output->updateFromNotify(crtc, mode, connection, resources->config_timestamp + 1);
+    QVERIFY(XCB::roundTrips() > round_trips);
+    QCOMPARE(output->crtc() ? output->crtc()->crtc() : XCB_NONE, crtc);
+}
+
+void TestXRandRConfig::test_crtc_rollback()
+{
+    // The test disables and enables outputs. Do not blank the screen of a running session.
+    if (qEnvironmentVariableIsEmpty("DISMAN_TEST_XVFB")) {
+        QSKIP("Set DISMAN_TEST_XVFB when running on a disposable X server like Xvfb.");
+    }
+
+    XRandRConfig config;
+
+    XRandRCrtc* crtc = nullptr;
+    for (auto const& [id, xCrtc] : config.crtcs()) {
+        if (!xCrtc->isFree()) {
+            crtc = xCrtc;
+            break;
+        }
+    }
+    if (!crtc) {
+        QSKIP("Test requires an enabled output.");
+    }
+
+    auto const mode = crtc->mode();
+    auto const geometry = crtc->geometry();
+    auto const outputs = crtc->outputs();
+
+    XRandRConfig::CrtcConfig unchanged;
+    unchanged.crtc = crtc->crtc();
+    unchanged.mode = mode;
+    unchanged.position = geometry.topLeft();
+    unchanged.rotation = crtc->rotation();
+    unchanged.outputs = outputs;
+    unchanged.transform.matrix11 = 1 << 16;
+    unchanged.transform.matrix22 = 1 << 16;
+    unchanged.transform.matrix33 = 1 << 16;
+    unchanged.filter = "nearest";
+
+    // No mode has this id, so the second request fails and the first one must be rolled back.
+    auto invalid = unchanged;
+    invalid.mode = 0x1fffffff;
+
+    auto const results = config.setCrtcConfigs({unchanged, invalid});
+    QCOMPARE(results.size(), size_t(2));
+    QVERIFY(results[0].success());
+    QVERIFY(results[0].rolledBack);
+    QVERIFY(!results[1].success());
+    QVERIFY(!results[1].rolledBack);
+
+    QCOMPARE(crtc->mode(), mode);
+    QCOMPARE(crtc->geometry(), geometry);
+    QCOMPARE(crtc->outputs(), outputs);
+}
+
+void TestXRandRConfig::bench_round_trips()
+{
+    auto const round_trips = XCB::roundTrips();
+    XRandRConfig config;
+    QTest::setBenchmarkResult(XCB::roundTrips() - round_trips, QTest::Events);
+}
+
+void TestXRandRConfig::bench_construct()
+{
+    QBENCHMARK
+    {
+        XRandRConfig config;
+    }
+}
+
+QTEST_MAIN(TestXRandRConfig)
+
+#include "xrandr_config.moc"
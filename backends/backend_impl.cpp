@@ -4,6 +4,7 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
 */
 #include "backend_impl.h"
+#include "configdiff.h"
 
 #include "device.h"
 #include "filer_controller.h"
@@ -11,20 +12,32 @@
 #include "logging.h"
 #include "output.h"
 
+#include <QElapsedTimer>
 #include <QRectF>
+#include <QTimer>
+
+#include <chrono>
 
 namespace Disman
 {
 
+constexpr std::chrono::seconds resume_grace_period{5};
+
 BackendImpl::BackendImpl()
     : Backend()
     , m_device{new Device}
     , m_filer_controller{new Filer_controller(m_device.get())}
 {
     connect(m_device.get(), &Device::lid_open_changed, this, &BackendImpl::load_lid_config);
+    connect(m_device.get(), &Device::about_to_sleep, this, &BackendImpl::take_sleep_snapshot);
+    connect(m_device.get(), &Device::resumed, this, &BackendImpl::restore_sleep_snapshot);
 }
 
-BackendImpl::~BackendImpl() = default;
+BackendImpl::~BackendImpl()
+{
+    // Control files are written asynchronously. Do not lose the last changes.
+    m_filer_controller->flush();
+}
 
 void BackendImpl::init([[maybe_unused]] QVariantMap const& arguments)
 {
@@ -44,6 +57,25 @@ Disman::ConfigPtr BackendImpl::config() const
     return config;
 }
 
+QVariantMap BackendImpl::collect_garbage(int max_count, int max_age)
+{
+    auto policy = Filer_gc::Policy::from_environment();
+    if (max_count >= 0) {
+        policy.max_count = max_count;
+    }
+    if (max_age >= 0) {
+        policy.max_age = max_age;
+    }
+
+    auto const result = m_filer_controller->collect_garbage(policy);
+
+    QVariantMap info;
+    info[QStringLiteral("removed")] = result.removed;
+    info[QStringLiteral("reclaimed-bytes")] = result.reclaimed_bytes;
+    info[QStringLiteral("kept")] = result.kept;
+    return info;
+}
+
 Disman::ConfigPtr BackendImpl::config_impl() const
 {
     auto config = std::make_shared<Config>();
@@ -60,15 +92,30 @@ Disman::ConfigPtr BackendImpl::config_impl() const
 
 void BackendImpl::set_config(Disman::ConfigPtr const& config)
 {
-    if (!config || config->compare(m_config)) {
+    if (!config) {
+        return;
+    }
+
+    auto const diff = ConfigDiff(m_config, config);
+    if (diff.empty()) {
         // No change by new config. Do nothing.
         return;
     }
+    qCDebug(DISMAN_BACKEND) << "Setting new config." << diff.log().c_str();
+
+    // Changes by the user must not be mistaken for a return to the state before sleep.
+    drop_sleep_snapshot();
 
     if (!set_config_impl(config)) {
+        if (m_config_failed) {
+            // Let clients know the config they set is not the current one.
+            Q_EMIT config_changed(this->config());
+            return;
+        }
         // No change to the system but other changes that need to be synced with other Disman
         // clients so emit a config_changed signal directly.
         m_config = config;
+        prepare_lid_close(config);
         Q_EMIT config_changed(config);
     }
 }
@@ -81,10 +128,18 @@ bool BackendImpl::set_config_impl(Disman::ConfigPtr const& config)
                                 << "\nNew config:" << config;
     }
 
-    m_filer_controller->write(config);
+    auto const sent = apply_config(config);
+    if (!m_config_failed) {
+        // Written only now, so a config the windowing system refused is not stored.
+        m_filer_controller->write(config);
+    }
+    return sent;
+}
 
+bool BackendImpl::apply_config(Disman::ConfigPtr const& config)
+{
     if (config->supported_features().testFlag(Config::Feature::OutputReplication)) {
-        for (auto const& [key, output] : config->outputs()) {
+        for (auto const& [key, output] : config->output_map()) {
             if (auto source_id = output->replication_source()) {
                 auto source = config->output(source_id);
                 output->set_position(source->position());
@@ -93,15 +148,59 @@ bool BackendImpl::set_config_impl(Disman::ConfigPtr const& config)
         }
     }
 
-    return set_config_system(config);
+    m_config_failed = false;
+    auto const sent = set_config_system(config);
+
+    if (m_config_failed) {
+        qCWarning(DISMAN_BACKEND) << "The windowing system did not accept the config.";
+        // Do not try it again on the next hot-plug.
+        m_filer_controller->forget_resolved(config);
+    }
+    return sent;
+}
+
+void BackendImpl::config_system_failed()
+{
+    m_config_failed = true;
 }
 
 bool BackendImpl::handle_config_change()
 {
-    // We need the config with its own cause, so we call config_impl here.
-    auto cfg = config_impl();
+    auto cfg = std::make_shared<Config>();
+    update_config(cfg);
 
-    if (!m_config || m_config->hash() != cfg->hash()) {
+    if (m_sleep_system_config && ConfigDiff(m_sleep_system_config, cfg).empty()) {
+        qCDebug(DISMAN_BACKEND) << "Config unchanged since going to sleep.";
+        return true;
+    }
+
+    auto const new_pattern = !m_config || m_config->fast_hash() != cfg->fast_hash();
+
+    if (new_pattern && m_filer_controller->read_resolved(cfg)) {
+        // Known output pattern. The config was resolved already when it was last set.
+        qCDebug(DISMAN_BACKEND) << "Config with known output pattern received:" << cfg;
+        m_config = cfg;
+
+        if (apply_config(cfg)) {
+            qCDebug(DISMAN_BACKEND) << "Resolved config for known output pattern sent.";
+            return false;
+        }
+        if (!m_config_failed) {
+            prepare_lid_close(cfg);
+            Q_EMIT config_changed(cfg);
+            return true;
+        }
+
+        // Continue with the control files instead.
+        cfg = std::make_shared<Config>();
+        update_config(cfg);
+    }
+
+    // We need the config with its own cause, so we do the rest of config_impl here.
+    m_filer_controller->read(cfg);
+    update_config(cfg);
+
+    if (new_pattern) {
         qCDebug(DISMAN_BACKEND) << "Config with new output pattern received:" << cfg;
 
         if (cfg->cause() == Config::Cause::unknown) {
@@ -122,8 +221,15 @@ bool BackendImpl::handle_config_change()
             qCDebug(DISMAN_BACKEND) << "Config for new output pattern sent.";
             return false;
         }
+        if (m_config_failed) {
+            // The windowing system keeps its own config.
+            cfg = std::make_shared<Config>();
+            update_config(cfg);
+            m_config = cfg;
+        }
     }
 
+    prepare_lid_close(cfg);
     Q_EMIT config_changed(cfg);
     return true;
 }
@@ -136,8 +242,17 @@ void BackendImpl::load_lid_config()
         return;
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!m_device->lid_open() && close_lid_precomputed()) {
+        qCDebug(DISMAN_BACKEND) << "Lid closed, precomputed config set after"
+                                << timer.nsecsElapsed() / 1000 << "us.";
+        return;
+    }
+
     auto cfg = config();
-    if (cfg->outputs().size() == 1) {
+    if (cfg->output_map().size() == 1) {
         // Open-lid configuration is only relevant with more than one output.
         return;
     }
@@ -169,6 +284,136 @@ void BackendImpl::load_lid_config()
     }
 
     set_config_impl(cfg);
+    qCDebug(DISMAN_BACKEND) << (m_device->lid_open() ? "Lid opened," : "Lid closed,")
+                            << "config set after" << timer.nsecsElapsed() / 1000 << "us.";
+}
+
+void BackendImpl::prepare_lid_close(ConfigPtr const& config)
+{
+    m_lid_open_config = config->clone();
+    m_lid_closed_config.reset();
+
+    if (!m_lid_close_scheduled) {
+        m_lid_close_scheduled = true;
+        QTimer::singleShot(0, this, &BackendImpl::precompute_lid_close);
+    }
+}
+
+void BackendImpl::precompute_lid_close()
+{
+    m_lid_close_scheduled = false;
+
+    if (!m_lid_open_config || !m_device->lid_present() || !m_device->lid_open()
+        || m_lid_open_config->output_map().size() == 1) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    Generator generator(m_lid_open_config);
+    if (!generator.disable_embedded()) {
+        return;
+    }
+
+    m_lid_closed_config = generator.config();
+    m_filer_controller->prepare_lid_file(m_lid_open_config);
+
+    qCDebug(DISMAN_BACKEND) << "Lid-closed config precomputed in" << timer.nsecsElapsed() / 1000
+                            << "us.";
+}
+
+bool BackendImpl::close_lid_precomputed()
+{
+    if (!m_lid_closed_config) {
+        return false;
+    }
+
+    // Only the output pattern must be the same. Changes to the outputs themselves would have
+    // triggered a new precomputation.
+    auto current = std::make_shared<Config>();
+    update_config(current);
+    if (current->fast_hash() != m_lid_open_config->fast_hash()) {
+        qCDebug(DISMAN_BACKEND) << "Output pattern changed since lid-closed config was computed.";
+        return false;
+    }
+
+    if (!m_filer_controller->save_lid_file(m_lid_open_config)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to save open-lid file.";
+        return false;
+    }
+
+    auto cfg = m_lid_closed_config;
+    m_lid_closed_config.reset();
+    set_config_impl(cfg);
+    return true;
+}
+
+void BackendImpl::take_sleep_snapshot()
+{
+    if (!m_config) {
+        return;
+    }
+
+    m_sleep_serial++;
+    m_sleep_system_config = std::make_shared<Config>();
+    update_config(m_sleep_system_config);
+    m_sleep_config = m_config->clone();
+}
+
+void BackendImpl::restore_sleep_snapshot()
+{
+    if (!m_sleep_system_config) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto current = std::make_shared<Config>();
+    update_config(current);
+
+    auto const diff = ConfigDiff(m_sleep_system_config, current);
+    auto const same_outputs = current->fast_hash() == m_sleep_system_config->fast_hash()
+        && diff.added_outputs().empty() && diff.removed_outputs().empty();
+
+    if (!same_outputs) {
+        qCDebug(DISMAN_BACKEND) << "Resumed with different outputs.";
+        drop_sleep_snapshot();
+        handle_config_change();
+        return;
+    }
+
+    if (diff.empty()) {
+        qCDebug(DISMAN_BACKEND) << "Resumed with config unchanged, checked in"
+                                << timer.nsecsElapsed() / 1000 << "us.";
+    } else {
+        // The windowing system lost some of our settings while sleeping. When nothing needs to be
+        // sent for them apply_config returns false, that is fine as well.
+        apply_config(m_sleep_config->clone());
+        if (m_config_failed) {
+            qCDebug(DISMAN_BACKEND) << "Config from before sleep could not be set.";
+            drop_sleep_snapshot();
+            handle_config_change();
+            return;
+        }
+        qCDebug(DISMAN_BACKEND) << "Resumed with config changed, set config from before sleep in"
+                                << timer.nsecsElapsed() / 1000 << "us.";
+    }
+
+    // The windowing system might still send change events from waking up. While the snapshot is
+    // kept these are ignored if they do not change anything compared to it.
+    QTimer::singleShot(resume_grace_period, this, [this, serial = m_sleep_serial] {
+        if (serial == m_sleep_serial) {
+            drop_sleep_snapshot();
+        }
+    });
+}
+
+void BackendImpl::drop_sleep_snapshot()
+{
+    m_sleep_system_config.reset();
+    m_sleep_config.reset();
 }
 
 }
@@ -28,10 +28,26 @@ public:
     ConfigPtr config() const override;
     void set_config(ConfigPtr const& config) override;
 
+    QVariantMap collect_garbage(int max_count, int max_age) override;
+
 protected:
     virtual void update_config(ConfigPtr& config) const = 0;
+
+    /**
+     * Sets @p config on the windowing system.
+     *
+     * @return true if changes were sent to the windowing system, false if it already is in the
+     * state of @p config or when @p config could not be set. In the latter case the backend calls
+     * config_system_failed() before returning.
+     */
     virtual bool set_config_system(ConfigPtr const& config) = 0;
 
+    /**
+     * Called from set_config_system when the windowing system refused the config. It then stays
+     * in its previous state and the config is neither stored nor used again.
+     */
+    void config_system_failed();
+
     /**
      * Handles a change in the window system. Sets a stored or generated config if needed and
      * returns false in this case. If the state correspondes to the stored state or is already
@@ -42,15 +58,44 @@ protected:
 private:
     ConfigPtr config_impl() const;
     bool set_config_impl(ConfigPtr const& config);
+    bool apply_config(ConfigPtr const& config);
 
     void load_lid_config();
 
+    /**
+     * Precomputes the config to set when the lid is closed with @p config being the current one.
+     * This happens asynchronously, so the current change is not delayed.
+     */
+    void prepare_lid_close(ConfigPtr const& config);
+    void precompute_lid_close();
+    bool close_lid_precomputed();
+
+    /**
+     * Snapshots the config before the system goes to sleep. On resume the windowing system is only
+     * compared against it and the config is set again if required.
+     */
+    void take_sleep_snapshot();
+    void restore_sleep_snapshot();
+    void drop_sleep_snapshot();
+
     std::unique_ptr<Device> m_device;
     std::unique_ptr<Filer_controller> m_filer_controller;
 
     mutable bool m_config_initialized{false};
 
+    // Set when the windowing system refused the config of the last apply_config call.
+    bool m_config_failed{false};
+
     ConfigPtr m_config;
+
+    ConfigPtr m_lid_open_config;
+    ConfigPtr m_lid_closed_config;
+    bool m_lid_close_scheduled{false};
+
+    // As reported by the windowing system and as set by us when going to sleep.
+    ConfigPtr m_sleep_system_config;
+    ConfigPtr m_sleep_config;
+    uint64_t m_sleep_serial{0};
 };
 
 }
@@ -134,9 +134,10 @@ void Device::prepare_for_sleep(bool start)
     qCDebug(DISMAN_BACKEND) << "Device sleep change:" << (start ? "going to sleep" : "waking up");
     if (start) {
         m_lid_timer->stop();
+        Q_EMIT about_to_sleep();
+    } else {
+        Q_EMIT resumed();
     }
-    // TODO: On start being false should we query the backend for changes in between? KDisplay
-    //       daemon does that.
 }
 
 }
@@ -33,6 +33,8 @@ public:
 
 Q_SIGNALS:
     void lid_open_changed();
+    void about_to_sleep();
+    void resumed();
 
 private Q_SLOTS:
     void fetch_lid_closed();
@@ -19,6 +19,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "filer_controller.h"
 #include "filer_helpers.h"
+#include "filer_writer.h"
 #include "output_filer.h"
 
 #include "logging.h"
@@ -27,12 +28,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <types.h>
 
 #include <QObject>
-#include <QStandardPaths>
 #include <QVariantMap>
 
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace Disman
@@ -46,22 +47,34 @@ public:
         , m_controller{controller}
         , m_suffix{suffix}
     {
-        m_dir_path = QString(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
-                             + QStringLiteral("/disman/control/"))
-                         .toStdString();
+        m_dir_path = control_dir_path();
         m_read_success = read_file();
 
-        for (auto const& [key, output] : config->outputs()) {
+        for (auto const& [key, output] : config->output_map()) {
             m_output_filers.push_back(
                 std::unique_ptr<Output_filer>(new Output_filer(output, m_controller, m_dir_path)));
         }
     }
 
+    /**
+     * Creates a filer for @p config without control files. Values set on it are only held in
+     * memory and can be read back with get_values().
+     */
+    explicit Filer(Disman::ConfigPtr const& config)
+        : m_config{config}
+        , m_controller{nullptr}
+        , m_read_success{true}
+    {
+        for (auto const& [key, output] : config->output_map()) {
+            m_output_filers.push_back(std::unique_ptr<Output_filer>(new Output_filer(output)));
+        }
+    }
+
     bool get_values(ConfigPtr& config)
     {
-        auto outputs = config->outputs();
+        auto const& outputs = config->output_map();
 
-        for (auto& [key, output] : outputs) {
+        for (auto const& [key, output] : outputs) {
             //
             // First we must set the retention for all later calls to get_value().
             auto retention = get_value(
@@ -121,8 +134,7 @@ public:
 
     void set_values(ConfigPtr const& config)
     {
-        auto outputs = config->outputs();
-        for (auto const& [key, output] : outputs) {
+        for (auto const& [key, output] : config->output_map()) {
             auto const retention = output->retention();
             Output_filer* filer = nullptr;
 
@@ -180,14 +192,8 @@ public:
           }) const
     {
         if (!filer || output->retention() == Output::Retention::Individual) {
-            auto const outputs_info = get_outputs_info();
-
-            for (auto const& variant_info : outputs_info) {
-                auto const info = variant_info.toMap();
-                if (is_info_for_output(info, output)) {
-                    auto const val = info[QString::fromStdString(id)];
-                    return getter(output, val, default_value);
-                }
+            if (auto info = get_output_info(output)) {
+                return getter(output, info->value(QString::fromStdString(id)), default_value);
             }
         }
 
@@ -210,34 +216,16 @@ public:
               info[QString::fromStdString(id)] = value;
           })
     {
-        QList<QVariant>::iterator it;
-        auto outputs_info = get_outputs_info();
-
-        auto set_output_value = [&]() {
-            if (filer) {
-                filer->set_value(id, value, setter);
-            }
-        };
-
-        for (it = outputs_info.begin(); it != outputs_info.end(); ++it) {
-            auto output_info = (*it).toMap();
-            if (!is_info_for_output(output_info, output)) {
-                continue;
-            }
-            setter(output_info, id, value);
-            *it = output_info;
-            set_outputs(outputs_info);
-            set_output_value();
-            return;
+        auto info = get_output_info(output);
+        if (!info) {
+            // No entry yet, create one.
+            info = add_output_info(output);
         }
+        setter(*info, id, value);
 
-        // No entry yet, create one.
-        auto output_info = Output_filer::create_info(output);
-        setter(output_info, id, value);
-
-        outputs_info << output_info;
-        set_outputs(outputs_info);
-        set_output_value();
+        if (filer) {
+            filer->set_value(id, value, setter);
+        }
     }
 
     static QPointF
@@ -300,7 +288,7 @@ public:
         info[QStringLiteral("mode")] = mode_info();
     }
 
-    void get_replication_source(OutputPtr& output, OutputMap const& outputs) const
+    void get_replication_source(OutputPtr const& output, OutputMap const& outputs) const
     {
         auto replicate_hash = get_value(output, "replicate", QString(), nullptr).toStdString();
 
@@ -330,36 +318,136 @@ public:
                   nullptr);
     }
 
-    std::string dir_path() const
+    /**
+     * The directory of all control files. Config control files are in its configs and output
+     * control files in its outputs subdirectory.
+     */
+    static std::string control_dir_path()
     {
-        return m_dir_path + "configs/";
+        return Filer_helpers::control_dir_path().toStdString();
     }
 
-    std::string file_name() const
+    static std::string dir_path()
     {
-        auto file_name = m_config->hash().toStdString();
-        if (!m_suffix.empty()) {
-            file_name += "-" + m_suffix;
+        return control_dir_path() + "configs/";
+    }
+
+    /**
+     * Control files are named by the 64-bit FNV-1a hash of the config. It is not collision
+     * resistant, but a system only ever sees a few output combinations, so an accidental collision
+     * is practically impossible. A deliberate one, for example through forged EDIDs, only mixes up
+     * the stored settings of two output combinations. That does not justify a longer hash.
+     */
+    static std::string file_name(ConfigPtr const& config, std::string const& suffix = "")
+    {
+        auto const hash = static_cast<qulonglong>(config->fast_hash());
+        return with_suffix(QStringLiteral("%1").arg(hash, 16, 16, QLatin1Char('0')).toStdString(),
+                           suffix);
+    }
+
+    /**
+     * Control files were named by the MD5 hash of the config before. These are still read as long
+     * as there is no file named by file_name(). They are not removed on write, so earlier versions
+     * still find their settings after a downgrade. Like other unused control files they are
+     * removed by the garbage collection once they are older than the maximal age.
+     */
+    static std::string legacy_file_name(ConfigPtr const& config, std::string const& suffix = "")
+    {
+        return with_suffix(config->hash().toStdString(), suffix);
+    }
+
+    /**
+     * The infos of the control files of @p config. These do not require reading any control file
+     * and so are cheap compared to constructing a filer.
+     */
+    static QFileInfo file_info(ConfigPtr const& config, std::string const& suffix = "")
+    {
+        return Filer_helpers::file_info(dir_path(), file_name(config, suffix));
+    }
+
+    static QFileInfo legacy_file_info(ConfigPtr const& config, std::string const& suffix = "")
+    {
+        return Filer_helpers::file_info(dir_path(), legacy_file_name(config, suffix));
+    }
+
+    /**
+     * The paths of the config control file and the output control files of @p config.
+     */
+    static QStringList file_paths(ConfigPtr const& config)
+    {
+        QStringList paths{file_info(config).filePath()};
+        for (auto const& [key, output] : config->output_map()) {
+            paths << Filer_helpers::file_info(control_dir_path() + "outputs/", output->hash())
+                         .filePath();
         }
-        return file_name;
+        return paths;
+    }
+
+    /**
+     * The info of the file to read from. If there is no control file with the current name but a
+     * legacy one this is the legacy one.
+     */
+    static QFileInfo existing_file_info(ConfigPtr const& config, std::string const& suffix = "")
+    {
+        auto const info = file_info(config, suffix);
+        if (Filer_helpers::file_exists(info)) {
+            return info;
+        }
+        if (auto const legacy_info = legacy_file_info(config, suffix);
+            Filer_helpers::file_exists(legacy_info)) {
+            return legacy_info;
+        }
+        return info;
     }
 
     QFileInfo file_info() const
     {
-        return Filer_helpers::file_info(dir_path(), file_name());
+        return file_info(m_config, m_suffix);
+    }
+
+    QFileInfo existing_file_info() const
+    {
+        return existing_file_info(m_config, m_suffix);
     }
 
     bool read_file()
     {
-        return Filer_helpers::read_file(file_info(), m_info);
+        auto const success = Filer_helpers::read_file(existing_file_info(), m_info);
+        index_outputs_info();
+        return success;
     }
 
-    bool write(ConfigPtr const& config)
+    /**
+     * The content of the control file in the layout it is written with.
+     */
+    QVariantMap info() const
     {
-        set_values(config);
+        auto info = m_info;
+        if (!m_outputs_info.empty()) {
+            QVariantList outputs_info;
+            outputs_info.reserve(static_cast<int>(m_outputs_info.size()));
+            for (auto const& output_info : m_outputs_info) {
+                outputs_info << output_info;
+            }
+            info[QStringLiteral("outputs")] = outputs_info;
+        }
+        return info;
+    }
 
-        bool success = true;
+    /**
+     * Queues writing the control files of @p config with the controller's writer.
+     */
+    void write(ConfigPtr const& config)
+    {
+        set_values(config);
+        write_files(config);
+    }
 
+    /**
+     * Queues writing the control files with the values set before from @p config.
+     */
+    void write_files(ConfigPtr const& config)
+    {
         for (auto& output_filer : m_output_filers) {
             auto const output = config->output(output_filer->output()->id());
             if (!output) {
@@ -372,13 +460,13 @@ public:
             if (output->retention() == Output::Retention::Individual) {
                 continue;
             }
-            success &= output_filer->write_file();
+            output_filer->write_file();
         }
 
-        success &= Filer_helpers::write_file(m_info, file_info());
-        return success;
+        m_controller->writer()->write(file_info().filePath(), info());
     }
 
+
     static Output::Retention convert_int_to_retention(int val)
     {
         if (val == static_cast<int>(Output::Retention::Global)) {
@@ -396,28 +484,62 @@ public:
     }
 
 private:
-    QVariantList get_outputs_info() const
+    static std::string with_suffix(std::string file_name, std::string const& suffix)
     {
-        return m_info[QStringLiteral("outputs")].toList();
+        if (!suffix.empty()) {
+            file_name += "-" + suffix;
+        }
+        return file_name;
     }
 
-    void set_outputs(QVariantList outputsInfo)
+    /**
+     * Moves the entries of the outputs list out of the read control file and indexes them by the
+     * output hash. This way the list is only assembled again on write.
+     */
+    void index_outputs_info()
     {
-        m_info[QStringLiteral("outputs")] = outputsInfo;
+        m_outputs_info.clear();
+        m_outputs_index.clear();
+
+        auto const outputs_info = m_info.take(QStringLiteral("outputs")).toList();
+        m_outputs_info.reserve(outputs_info.size());
+
+        for (auto const& variant_info : outputs_info) {
+            auto info = variant_info.toMap();
+            auto const hash = info.value(QStringLiteral("id")).toString().toStdString();
+            if (!hash.empty()) {
+                // In case of duplicate entries the first one is used.
+                m_outputs_index.insert({hash, m_outputs_info.size()});
+            }
+            m_outputs_info.push_back(std::move(info));
+        }
     }
 
-    bool is_info_for_output(QVariantMap const& info, OutputPtr const& output) const
+    QVariantMap const* get_output_info(OutputPtr const& output) const
     {
-        auto const output_id_info = info[QStringLiteral("id")].toString().toStdString();
-
-        if (!output_id_info.size()) {
-            return false;
+        auto const it = m_outputs_index.find(output->hash());
+        if (it == m_outputs_index.cend()) {
+            return nullptr;
         }
-        if (output->hash() != output_id_info) {
-            return false;
+        return &m_outputs_info[it->second];
+    }
+
+    QVariantMap* get_output_info(OutputPtr const& output)
+    {
+        auto const it = m_outputs_index.find(output->hash());
+        if (it == m_outputs_index.cend()) {
+            return nullptr;
         }
+        return &m_outputs_info[it->second];
+    }
 
-        return true;
+    QVariantMap* add_output_info(OutputPtr const& output)
+    {
+        if (!output->hash().empty()) {
+            m_outputs_index.insert({output->hash(), m_outputs_info.size()});
+        }
+        m_outputs_info.push_back(Output_filer::create_info(output));
+        return &m_outputs_info.back();
     }
 
     Output_filer* get_output_filer(OutputPtr const& output) const
@@ -438,7 +560,13 @@ private:
     std::string m_dir_path;
     std::string m_suffix;
 
+    // Content of the control file apart from the outputs list.
     QVariantMap m_info;
+
+    // Entries of the outputs list in file order and their indices by output hash.
+    std::vector<QVariantMap> m_outputs_info;
+    std::unordered_map<std::string, size_t> m_outputs_index;
+
     bool m_read_success{false};
 };
 
@@ -0,0 +1,163 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "filer_cache.h"
+
+#include "filer_helpers.h"
+#include "logging.h"
+
+#include <QCborMap>
+#include <QCborValue>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace Disman
+{
+
+namespace
+{
+
+constexpr qint64 shadow_format_version = 1;
+
+enum shadow_key : qint64 {
+    shadow_version = 0,
+    shadow_modified = 1,
+    shadow_size = 2,
+    shadow_content = 3,
+};
+
+}
+
+Filer_cache& Filer_cache::instance()
+{
+    static Filer_cache cache;
+    return cache;
+}
+
+bool Filer_cache::read(QFileInfo const& file_info, QVariantMap& info)
+{
+    auto const path = file_info.filePath();
+
+    // The passed in info might have cached stale data.
+    QFileInfo const current(path);
+
+    auto const exists = current.exists();
+    auto const modified = current.lastModified();
+    auto const size = current.size();
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (!exists) {
+            m_entries.erase(path);
+            return false;
+        }
+
+        if (auto it = m_entries.find(path); it != m_entries.end()) {
+            if (it->second.modified == modified && it->second.size == size) {
+                info = it->second.info;
+                return true;
+            }
+            m_entries.erase(it);
+        }
+    }
+
+    // Files are read without holding the lock, so the writer thread is not blocked meanwhile.
+    auto const shadow_read = read_shadow(path, modified, size, info);
+    if (!shadow_read) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qCWarning(DISMAN_BACKEND) << "Failed to open config control file for reading."
+                                      << file.errorString();
+            return false;
+        }
+        info = QJsonDocument::fromJson(file.readAll()).toVariant().toMap();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_entries[path] = {modified, size, info};
+    }
+
+    if (!shadow_read) {
+        write_shadow(path, modified, size, info);
+    }
+    return true;
+}
+
+void Filer_cache::invalidate(QString const& path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.erase(path);
+}
+
+QString Filer_cache::shadow_path(QString const& path)
+{
+    auto const relative_path = QDir(Filer_helpers::control_dir_path()).relativeFilePath(path);
+    if (relative_path.startsWith(QStringLiteral(".."))) {
+        return QString();
+    }
+
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + QStringLiteral("/disman/control/") + relative_path + QStringLiteral(".cbor");
+}
+
+bool Filer_cache::read_shadow(QString const& path,
+                              QDateTime const& modified,
+                              qint64 size,
+                              QVariantMap& info)
+{
+    auto const shadow = shadow_path(path);
+    if (shadow.isEmpty()) {
+        return false;
+    }
+
+    QFile file(shadow);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    auto const map = QCborValue::fromCbor(file.readAll()).toMap();
+    if (map.value(shadow_version).toInteger() != shadow_format_version
+        || map.value(shadow_modified).toInteger() != modified.toMSecsSinceEpoch()
+        || map.value(shadow_size).toInteger() != size) {
+        // Outdated, the JSON file was changed since.
+        return false;
+    }
+
+    info = map.value(shadow_content).toMap().toVariantMap();
+    return true;
+}
+
+void Filer_cache::write_shadow(QString const& path,
+                               QDateTime const& modified,
+                               qint64 size,
+                               QVariantMap const& info)
+{
+    auto const shadow = shadow_path(path);
+    if (shadow.isEmpty() || !QDir().mkpath(QFileInfo(shadow).path())) {
+        return;
+    }
+
+    QCborMap map;
+    map[shadow_version] = shadow_format_version;
+    map[shadow_modified] = modified.toMSecsSinceEpoch();
+    map[shadow_size] = size;
+    map[shadow_content] = QCborMap::fromVariantMap(info);
+
+    QSaveFile file(shadow);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(DISMAN_BACKEND) << "Failed to open shadow control file." << file.errorString();
+        return;
+    }
+    file.write(map.toCborValue().toCbor());
+    file.commit();
+}
+
+}
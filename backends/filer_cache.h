@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+
+#include <map>
+
+namespace Disman
+{
+
+/**
+ * Process-wide cache of parsed control files.
+ *
+ * Entries are keyed by file path and only used while the modification time and size of the file
+ * are unchanged. Code changing control files should still invalidate them explicitly, since a
+ * rename keeps the modification time of the source file.
+ *
+ * On a miss the parsed content is also stored as a binary CBOR shadow copy in the cache directory.
+ * Later processes read the shadow copy instead of parsing the JSON file again, as long as it
+ * records the modification time and size the JSON file has now. The JSON file stays authoritative
+ * and can still be edited by hand.
+ *
+ * Control files are written on a worker thread, so the cache is thread-safe.
+ */
+class Filer_cache
+{
+public:
+    static Filer_cache& instance();
+
+    /**
+     * Reads the control file at @p file_info into @p info. Only parses the file when it is not
+     * cached or changed on disk.
+     *
+     * @return false if the file does not exist or can not be read
+     */
+    bool read(QFileInfo const& file_info, QVariantMap& info);
+
+    void invalidate(QString const& path);
+
+    /**
+     * The path of the shadow copy of the control file at @p path. Empty if @p path is not in the
+     * control directory.
+     */
+    static QString shadow_path(QString const& path);
+
+private:
+    Filer_cache() = default;
+
+    static bool
+    read_shadow(QString const& path, QDateTime const& modified, qint64 size, QVariantMap& info);
+    static void write_shadow(QString const& path,
+                             QDateTime const& modified,
+                             qint64 size,
+                             QVariantMap const& info);
+
+    struct Entry {
+        QDateTime modified;
+        qint64 size;
+        QVariantMap info;
+    };
+
+    QMutex m_mutex;
+    std::map<QString, Entry> m_entries;
+};
+
+}
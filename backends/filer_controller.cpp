@@ -19,22 +19,97 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "device.h"
 #include "filer.h"
+#include "filer_gc.h"
+#include "filer_store.h"
+#include "filer_writer.h"
 #include "logging.h"
 
+#include <QTimer>
+
+#include <chrono>
+
 namespace Disman
 {
 
+constexpr std::chrono::minutes gc_delay{5};
+
+static bool same_outputs(ConfigPtr const& config, ConfigPtr const& other)
+{
+    if (config->output_map().size() != other->output_map().size()) {
+        return false;
+    }
+    for (auto const& [id, output] : config->output_map()) {
+        auto const other_output = other->output(id);
+        if (!other_output || other_output->hash() != output->hash()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sets the values of @p resolved that are held in control files by passing them through a filer
+// without files. Values provided by the windowing system, like the available modes, are kept.
+static bool apply_resolved(ConfigPtr& config, ConfigPtr const& resolved)
+{
+    Filer filer(config);
+    filer.set_values(resolved);
+    filer.get_values(config);
+
+    for (auto const& [id, output] : config->output_map()) {
+        // Mode ids might be different now. The filer looks the mode up by its values.
+        if (resolved->output(id)->auto_mode() && !output->commanded_mode()) {
+            return false;
+        }
+    }
+
+    config->set_cause(resolved->cause());
+    return true;
+}
+
 Filer_controller::Filer_controller(Device* device, QObject* parent)
     : QObject(parent)
+    , m_writer{new Filer_writer}
     , m_device{device}
 {
+    auto const policy = Filer_gc::Policy::from_environment();
+    if (!policy.automatic) {
+        return;
+    }
+
+    // Unused control files are collected once the backend settled, so startup is not delayed.
+    QTimer::singleShot(gc_delay, this, [this, policy] {
+        write_usage();
+        m_writer->schedule([policy] { Filer_gc::collect(policy); });
+    });
 }
 
-Filer_controller::~Filer_controller() = default;
+Filer_controller::~Filer_controller()
+{
+    write_usage();
+}
+
+void Filer_controller::flush()
+{
+    m_writer->flush();
+}
+
+Filer_gc::Result Filer_controller::collect_garbage(Filer_gc::Policy const& policy)
+{
+    Filer_gc::Result result;
+    write_usage();
+    m_writer->schedule([&result, policy] { result = Filer_gc::collect(policy); });
+    flush();
+    return result;
+}
+
+Filer_writer* Filer_controller::writer() const
+{
+    return m_writer.get();
+}
 
 bool Filer_controller::read(ConfigPtr& config)
 {
-    if (!m_filer || m_filer->config()->hash() != config->hash()) {
+    if (!m_filer || m_filer->config()->fast_hash() != config->fast_hash()) {
         if (lid_file_exists(config) && m_device->lid_present() && m_device->lid_open()) {
             // Can happen when while lid closed output combination changes or device is shut down.
             move_lid_file(config);
@@ -54,7 +129,7 @@ bool Filer_controller::read(ConfigPtr& config)
 bool Filer_controller::write(ConfigPtr const& config)
 {
     if (m_filer) {
-        if (m_filer->config()->hash() != config->hash()) {
+        if (m_filer->config()->fast_hash() != config->fast_hash()) {
             qCWarning(DISMAN_BACKEND)
                 << "Config control file not in sync. Was there a simultaneous hot-plug event?";
             return false;
@@ -63,7 +138,86 @@ bool Filer_controller::write(ConfigPtr const& config)
         reset_filer(config);
     }
 
-    return m_filer->write(config);
+    m_filer->write(config);
+    remember_resolved(config);
+    return true;
+}
+
+bool Filer_controller::read_resolved(ConfigPtr& config)
+{
+    auto it = m_resolved_configs.find(config->fast_hash());
+    if (it == m_resolved_configs.end()) {
+        return false;
+    }
+
+    if (m_device->lid_present() && m_device->lid_open() && lid_file_exists(config)) {
+        // Needs to be moved back first.
+        return false;
+    }
+
+    auto const& resolved = it->second;
+
+    if (!same_outputs(config, resolved.config)) {
+        qCDebug(DISMAN_BACKEND) << "Outputs changed their ids. Not using resolved config.";
+        m_resolved_configs.erase(it);
+        return false;
+    }
+    if (!resolved.stamps.empty() && resolved.stamps != take_stamps(resolved.config)) {
+        qCDebug(DISMAN_BACKEND) << "Control files changed on disk. Not using resolved config.";
+        m_resolved_configs.erase(it);
+        return false;
+    }
+
+    // The config of the windowing system is kept, so it stays untouched if this fails.
+    auto cfg = config->clone();
+    if (!apply_resolved(cfg, resolved.config)) {
+        qCDebug(DISMAN_BACKEND) << "Resolved mode is not available. Not using resolved config.";
+        m_resolved_configs.erase(it);
+        return false;
+    }
+    config = cfg;
+
+    // The filer is only needed for the next write and is then created again.
+    m_filer.reset();
+    record_usage(config);
+    return true;
+}
+
+void Filer_controller::forget_resolved(ConfigPtr const& config)
+{
+    m_resolved_configs.erase(config->fast_hash());
+}
+
+void Filer_controller::remember_resolved(ConfigPtr const& config)
+{
+    auto const hash = config->fast_hash();
+    auto const serial = ++m_resolved_serial;
+    m_resolved_configs[hash] = {config->clone(), {}, serial};
+
+    // Our own writes change the files, so they are compared against the state after these.
+    m_writer->call_when_written([this, hash, serial] {
+        auto it = m_resolved_configs.find(hash);
+        if (it != m_resolved_configs.end() && it->second.serial == serial) {
+            it->second.stamps = take_stamps(it->second.config);
+        }
+    });
+}
+
+std::vector<Filer_controller::Stamp> Filer_controller::take_stamps(ConfigPtr const& config)
+{
+    std::vector<Stamp> stamps;
+    auto const store = Filer_store::instance();
+
+    for (auto const& path : Filer::file_paths(config)) {
+        if (store) {
+            // No files are written to disk then.
+            stamps.emplace_back(path, QDateTime(), 0, store->revision(path));
+            continue;
+        }
+        QFileInfo const info(path);
+        stamps.emplace_back(path, info.lastModified(), info.size(), 0);
+    }
+    return stamps;
 }
 
 bool Filer_controller::load_lid_file(ConfigPtr& config)
@@ -81,29 +235,87 @@ bool Filer_controller::load_lid_file(ConfigPtr& config)
 
 bool Filer_controller::lid_file_exists(ConfigPtr const& config)
 {
-    auto const file_info = Filer(config, this, "open-lid").file_info();
-    return QFile(file_info.filePath()).exists();
+    flush();
+    return Filer_helpers::file_exists(Filer::existing_file_info(config, "open-lid"));
 }
 
 bool Filer_controller::move_lid_file(ConfigPtr const& config)
 {
     assert(lid_file_exists(config));
+    flush();
+
+    auto const file_path = Filer::file_info(config).filePath();
+    auto const lid_file_path = Filer::existing_file_info(config, "open-lid").filePath();
 
-    auto const file_info = Filer(config, this).file_info();
-    QFile(file_info.filePath()).remove();
+    // Changes the control files without a write.
+    m_resolved_configs.clear();
 
-    auto const lid_file_info = Filer(config, this, "open-lid").file_info();
-    return QFile::rename(lid_file_info.filePath(), file_info.filePath());
+    Filer_helpers::remove_file(file_path);
+    return Filer_helpers::rename_file(lid_file_path, file_path);
 }
 
 bool Filer_controller::save_lid_file(ConfigPtr const& config)
 {
-    return Filer(config, this, "open-lid").write(config);
+    if (m_lid_filer && m_lid_filer_config == config) {
+        m_lid_filer->write_files(config);
+        m_lid_filer.reset();
+        m_lid_filer_config.reset();
+        return true;
+    }
+
+    flush();
+    Filer(config, this, "open-lid").write(config);
+    return true;
+}
+
+void Filer_controller::prepare_lid_file(ConfigPtr const& config)
+{
+    m_lid_filer.reset();
+    m_lid_filer_config = config;
+
+    // The filer reads the control files, so they must be up to date. Instead of flushing wait for
+    // the writes to not block.
+    m_writer->call_when_written([this, config] {
+        if (m_lid_filer_config != config) {
+            return;
+        }
+        m_lid_filer.reset(new Filer(config, this, "open-lid"));
+        m_lid_filer->set_values(config);
+    });
 }
 
 void Filer_controller::reset_filer(ConfigPtr const& config)
 {
+    // The new filer reads the files, so they must be up to date.
+    flush();
     m_filer.reset(new Filer(config, this));
+    record_usage(config);
+}
+
+void Filer_controller::record_usage(ConfigPtr const& config)
+{
+    // Only kept in memory, so hot-plugs do not read and write the usage file.
+    Filer_gc::touch(m_usage, Filer::file_paths(config));
+}
+
+void Filer_controller::write_usage()
+{
+    if (m_usage.isEmpty()) {
+        return;
+    }
+
+    m_writer->schedule([usage = std::move(m_usage)] {
+        // Read on the writer thread since the garbage collection changes the file.
+        auto const path = Filer_gc::usage_path();
+        QVariantMap info;
+        Filer_helpers::read_file(QFileInfo(path), info);
+
+        for (auto it = usage.cbegin(); it != usage.cend(); ++it) {
+            info.insert(it.key(), it.value());
+        }
+        Filer_helpers::write_file(info, QFileInfo(path));
+    });
+    m_usage.clear();
 }
 
 }
@@ -17,18 +17,26 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 **************************************************************************/
 #pragma once
 
+#include "filer_gc.h"
 #include "types.h"
 
 #include "disman_export.h"
 
+#include <QDateTime>
 #include <QObject>
+#include <QString>
+#include <QVariantMap>
 
+#include <map>
 #include <memory>
+#include <tuple>
+#include <vector>
 
 namespace Disman
 {
 class Device;
 class Filer;
+class Filer_writer;
 
 /**
  * Side-channel controller for writing additional data to control files through the @ref Filer and
@@ -51,24 +59,93 @@ public:
     bool read(ConfigPtr& config);
 
     /**
-     * Write @param config to file on disk.
+     * Read in the config resolved for the output combination of @p config when it was last
+     * written. On known output combinations this replaces reading the control files and
+     * generating a config.
+     *
+     * The resolved config is only used while the outputs have the same ids as back then and the
+     * control files were not changed on disk since. Only the values stored in control files are
+     * taken from it, modes are looked up again by resolution and refresh rate.
+     *
+     * @param config the current config of the windowing system, replaced on success
+     * @return true when a resolved config was found, otherwise false
+     */
+    bool read_resolved(ConfigPtr& config);
+
+    /**
+     * Drops the resolved config for the output combination of @p config, for example when it
+     * could not be set.
+     */
+    void forget_resolved(ConfigPtr const& config);
+
+    /**
+     * Write @param config to file on disk. The files are written asynchronously.
      *
      * @param config provides configuration data to write
-     * @return true if write successful, otherwise false
+     * @return true if the write was queued, otherwise false
      */
     bool write(ConfigPtr const& config);
 
     bool load_lid_file(ConfigPtr& config);
     bool save_lid_file(ConfigPtr const& config);
 
+    /**
+     * Prepares saving @p config as open-lid file, so a later call to save_lid_file with the same
+     * config object only needs to queue the writes.
+     */
+    void prepare_lid_file(ConfigPtr const& config);
+
+    /**
+     * Blocks until all queued writes are on disk. Call before shutting down.
+     */
+    void flush();
+
+    /**
+     * Removes unused control files according to @p policy on the writer thread after all queued
+     * writes. Blocks until the collection is done.
+     */
+    Filer_gc::Result collect_garbage(Filer_gc::Policy const& policy);
+
+    Filer_writer* writer() const;
+
 private:
     bool lid_file_exists(ConfigPtr const& config);
     bool move_lid_file(ConfigPtr const& config);
 
     void reset_filer(ConfigPtr const& config);
+    void record_usage(ConfigPtr const& config);
+
+    /**
+     * Merges the usage recorded since the last call into the usage file on the writer thread.
+     * Happens before each garbage collection and on shutdown.
+     */
+    void write_usage();
 
+    // Path, modification time and size of a control file, and its revision in the control store.
+    using Stamp = std::tuple<QString, QDateTime, qint64, uint64_t>;
+
+    struct Resolved_config {
+        ConfigPtr config;
+        // Empty while the control files are still being written.
+        std::vector<Stamp> stamps;
+        uint64_t serial;
+    };
+
+    void remember_resolved(ConfigPtr const& config);
+    static std::vector<Stamp> take_stamps(ConfigPtr const& config);
+
+    std::unique_ptr<Filer_writer> m_writer;
     std::unique_ptr<Filer> m_filer;
     Device* m_device;
+
+    std::unique_ptr<Filer> m_lid_filer;
+    ConfigPtr m_lid_filer_config;
+
+    std::map<uint64_t, Resolved_config> m_resolved_configs;
+    uint64_t m_resolved_serial{0};
+
+    // Last uses of control files not yet in the usage file.
+    QVariantMap m_usage;
 };
 
 }
@@ -0,0 +1,157 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "filer_gc.h"
+
+#include "filer_cache.h"
+#include "filer_helpers.h"
+#include "filer_store.h"
+#include "logging.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <vector>
+
+namespace Disman
+{
+
+namespace
+{
+
+constexpr qint64 seconds_per_day = 24 * 60 * 60;
+
+int policy_value(char const* name, int default_value)
+{
+    bool ok;
+    auto const value = qEnvironmentVariableIntValue(name, &ok);
+    if (!ok || value < 0) {
+        return default_value;
+    }
+    return value;
+}
+
+/// Open-lid files hold the config to restore when the lid is opened again. They are only used
+/// after the lid was closed, what might be long ago, so they are never removed.
+bool is_lid_file(QString const& path)
+{
+    return path.endsWith(QStringLiteral("-open-lid.json"));
+}
+
+}
+
+Filer_gc::Policy Filer_gc::Policy::from_environment()
+{
+    Policy policy;
+    policy.max_count = policy_value("DISMAN_CONTROL_MAX_COUNT", policy.max_count);
+    policy.max_age = policy_value("DISMAN_CONTROL_MAX_AGE", policy.max_age);
+    policy.automatic = qEnvironmentVariableIntValue("DISMAN_CONTROL_GC") != 0;
+    return policy;
+}
+
+QString Filer_gc::usage_path()
+{
+    return Filer_helpers::control_dir_path() + QStringLiteral("usage.json");
+}
+
+void Filer_gc::touch(QVariantMap& usage, QStringList const& paths, QDateTime const& now)
+{
+    QDir const dir(Filer_helpers::control_dir_path());
+    for (auto const& path : paths) {
+        usage[dir.relativeFilePath(path)] = now.toSecsSinceEpoch();
+    }
+}
+
+Filer_gc::Result Filer_gc::collect(Policy const& policy, QDateTime const& now)
+{
+    struct File {
+        QString path;
+        QString key;
+        qint64 last_used;
+    };
+
+    QDir const dir(Filer_helpers::control_dir_path());
+    auto const now_secs = now.toSecsSinceEpoch();
+    auto const store = Filer_store::instance();
+    auto const store_size = store ? store->size() : 0;
+
+    QVariantMap usage;
+    Filer_helpers::read_file(QFileInfo(usage_path()), usage);
+
+    Result result;
+    QVariantMap kept_usage;
+
+    for (auto const& sub_dir : {QStringLiteral("configs/"), QStringLiteral("outputs/")}) {
+        std::vector<File> files;
+
+        for (auto const& path : Filer_helpers::list_files(dir.filePath(sub_dir))) {
+            auto const key = dir.relativeFilePath(path);
+            if (is_lid_file(path)) {
+                if (auto it = usage.constFind(key); it != usage.constEnd()) {
+                    kept_usage[key] = *it;
+                }
+                result.kept++;
+                continue;
+            }
+
+            auto last_used = now_secs;
+
+            if (auto it = usage.constFind(key); it != usage.constEnd()) {
+                last_used = it->toLongLong();
+            } else if (!store) {
+                last_used = QFileInfo(path).lastModified().toSecsSinceEpoch();
+            }
+            files.push_back({path, key, last_used});
+        }
+
+        std::sort(files.begin(), files.end(), [](auto const& file1, auto const& file2) {
+            return file1.last_used > file2.last_used;
+        });
+
+        for (size_t index = 0; index < files.size(); index++) {
+            auto const& file = files.at(index);
+
+            auto const expired = policy.max_age > 0
+                && now_secs - file.last_used > policy.max_age * seconds_per_day;
+            auto const surplus
+                = policy.max_count > 0 && index >= static_cast<size_t>(policy.max_count);
+
+            if (!expired && !surplus) {
+                kept_usage[file.key] = file.last_used;
+                result.kept++;
+                continue;
+            }
+
+            auto const size = store ? 0 : QFileInfo(file.path).size();
+            if (!Filer_helpers::remove_file(file.path)) {
+                qCWarning(DISMAN_BACKEND) << "Failed to remove control file" << file.path;
+                kept_usage[file.key] = file.last_used;
+                result.kept++;
+                continue;
+            }
+
+            if (auto const shadow = Filer_cache::shadow_path(file.path); !shadow.isEmpty()) {
+                QFile::remove(shadow);
+            }
+            result.removed << file.path;
+            result.reclaimed_bytes += size;
+        }
+    }
+
+    Filer_helpers::write_file(kept_usage, QFileInfo(usage_path()));
+
+    if (store) {
+        store->compact();
+        result.reclaimed_bytes = std::max<qint64>(store_size - store->size(), 0);
+    }
+
+    qCDebug(DISMAN_BACKEND) << "Removed" << result.removed.size() << "unused control files,"
+                            << result.kept << "are left.";
+    return result;
+}
+
+}
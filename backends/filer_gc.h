@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+namespace Disman
+{
+
+/**
+ * Removes control files that were not used for a long time.
+ *
+ * When control files are used, their paths are recorded with the current time in the usage file of
+ * the control directory. Files without a record count as last used when they were last modified.
+ *
+ * A collection removes from the configs and outputs directories all files not used for longer than
+ * the maximal age. If more files than the maximal count are left in a directory, also the least
+ * recently used ones are removed. Open-lid files are always kept.
+ *
+ * A collection is run on explicit request only, unless automatic collection is enabled through the
+ * policy.
+ */
+class Filer_gc
+{
+public:
+    struct Policy {
+        /// Maximal number of files per directory. Zero for no limit.
+        int max_count{100};
+        /// Maximal number of days since the last use. Zero for no limit.
+        int max_age{365};
+        /// If files are collected automatically some time after the backend started.
+        bool automatic{false};
+
+        /**
+         * The default policy, adapted by the environment variables DISMAN_CONTROL_MAX_COUNT,
+         * DISMAN_CONTROL_MAX_AGE and DISMAN_CONTROL_GC.
+         */
+        static Policy from_environment();
+    };
+
+    struct Result {
+        QStringList removed;
+        qint64 reclaimed_bytes{0};
+        int kept{0};
+    };
+
+    static QString usage_path();
+
+    /**
+     * Records in @p usage that the control files at @p paths are used at @p now.
+     */
+    static void touch(QVariantMap& usage,
+                      QStringList const& paths,
+                      QDateTime const& now = QDateTime::currentDateTimeUtc());
+
+    /**
+     * Removes control files according to @p policy. Pending writes must be flushed before.
+     */
+    static Result collect(Policy const& policy,
+                          QDateTime const& now = QDateTime::currentDateTimeUtc());
+};
+
+}
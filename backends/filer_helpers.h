@@ -17,68 +17,124 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 **************************************************************************/
 #pragma once
 
+#include "filer_cache.h"
+#include "filer_store.h"
 #include "logging.h"
 
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QVariant>
 #include <QVariantMap>
 
 namespace Disman::Filer_helpers
 {
 
-static bool read_file(QFileInfo const& file_info, QVariantMap& info)
+inline QString control_dir_path()
 {
-    QFile file(file_info.filePath());
-    if (!file.exists()) {
-        return false;
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+        + QStringLiteral("/disman/control/");
+}
+
+inline bool file_exists(QFileInfo const& file_info)
+{
+    if (auto store = Filer_store::instance()) {
+        return store->contains(file_info.filePath());
     }
+    return file_info.exists();
+}
 
-    if (!file.open(QIODevice::ReadOnly)) {
-        qCWarning(DISMAN_BACKEND) << "Failed to open config control file for reading."
-                                  << file.errorString();
-        return false;
+/**
+ * The paths of the control files in the directory at @p dir_path.
+ */
+inline QStringList list_files(QString const& dir_path)
+{
+    if (auto store = Filer_store::instance()) {
+        return store->paths(dir_path);
     }
 
-    QJsonDocument parser;
-    info = parser.fromJson(file.readAll()).toVariant().toMap();
-    return true;
+    QStringList paths;
+    auto const infos = QDir(dir_path).entryInfoList({QStringLiteral("*.json")}, QDir::Files);
+    for (auto const& info : infos) {
+        paths << info.filePath();
+    }
+    return paths;
 }
 
-static QFileInfo file_info(std::string const& dir_path, std::string const& hash)
+inline bool read_file(QFileInfo const& file_info, QVariantMap& info)
+{
+    if (auto store = Filer_store::instance()) {
+        return store->read(file_info.filePath(), info);
+    }
+    return Filer_cache::instance().read(file_info, info);
+}
+
+inline bool remove_file(QString const& path)
+{
+    if (auto store = Filer_store::instance()) {
+        return store->remove(path);
+    }
+    auto const success = QFile::remove(path);
+    Filer_cache::instance().invalidate(path);
+    return success;
+}
+
+inline bool rename_file(QString const& from, QString const& to)
+{
+    if (auto store = Filer_store::instance()) {
+        return store->rename(from, to);
+    }
+    auto const success = QFile::rename(from, to);
+    Filer_cache::instance().invalidate(from);
+    Filer_cache::instance().invalidate(to);
+    return success;
+}
+
+inline QFileInfo file_info(std::string const& dir_path, std::string const& hash)
 {
     return QFileInfo(QDir(QString::fromStdString(dir_path)),
                      QString::fromStdString(hash + ".json"));
 }
 
-static bool write_file(QVariantMap const& map, QFileInfo const& file_info)
+inline bool write_file(QVariantMap const& map, QFileInfo const& file_info)
 {
     if (map.isEmpty()) {
         // Nothing to write. Default control. Remove file if it exists.
-        QFile::remove(file_info.filePath());
+        remove_file(file_info.filePath());
         return true;
     }
+    if (auto store = Filer_store::instance()) {
+        return store->write(file_info.filePath(), map);
+    }
     if (!QDir().mkpath(file_info.path())) {
         // TODO: error message
         return false;
     }
 
-    // write updated data to file
-    QFile file(file_info.filePath());
+    // Write to a temporary file first and replace the old one at the end. This way a crash in
+    // between does not leave a truncated file behind.
+    QSaveFile file(file_info.filePath());
     if (!file.open(QIODevice::WriteOnly)) {
         qCWarning(DISMAN_BACKEND) << "Failed to open config control file for writing."
                                   << file.errorString();
         return false;
     }
     file.write(QJsonDocument::fromVariant(map).toJson());
+    auto const success = file.commit();
+    Filer_cache::instance().invalidate(file_info.filePath());
+    if (!success) {
+        qCWarning(DISMAN_BACKEND) << "Failed to save config control file." << file.errorString();
+        return false;
+    }
     qCDebug(DISMAN_BACKEND) << "Control saved to:" << file.fileName();
     return true;
 }
 
 template<typename T>
-static T from_variant(QVariant const& var, T default_value = T())
+inline T from_variant(QVariant const& var, T default_value = T())
 {
     if (var.canConvert<double>()) {
         return var.toDouble();
@@ -91,7 +147,7 @@ static T from_variant(QVariant const& var, T default_value = T())
 }
 
 template<>
-QString from_variant(QVariant const& var, QString default_value)
+inline QString from_variant(QVariant const& var, QString default_value)
 {
     if (var.canConvert<QString>()) {
         return var.toString();
@@ -0,0 +1,339 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "filer_store.h"
+
+#include "filer_helpers.h"
+#include "logging.h"
+
+#include <QCborArray>
+#include <QCborMap>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <memory>
+
+namespace Disman
+{
+
+namespace
+{
+
+constexpr char log_magic[] = "DMCL";
+constexpr quint32 log_version = 1;
+constexpr int header_size = 8;
+
+// Outdated records tolerated on top of the live ones before the log is compacted.
+constexpr size_t compaction_slack = 64;
+
+QByteArray encode_header()
+{
+    QByteArray header(log_magic, 4);
+    header.resize(header_size);
+    qToLittleEndian<quint32>(log_version, header.data() + 4);
+    return header;
+}
+
+/**
+ * A record is the size of its payload as 32-bit little-endian integer followed by the payload, a
+ * CBOR array of the key and the content. Removals have a null content.
+ */
+QByteArray encode_record(QString const& key, QCborValue const& value)
+{
+    auto const payload = QCborArray{key, value}.toCborValue().toCbor();
+
+    QByteArray record(4, 0);
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), record.data());
+    return record + payload;
+}
+
+}
+
+Filer_store* Filer_store::instance()
+{
+    static std::unique_ptr<Filer_store> store = []() -> std::unique_ptr<Filer_store> {
+        if (qgetenv("DISMAN_CONTROL_STORE") != QByteArray("log")) {
+            return nullptr;
+        }
+        return open(Filer_helpers::control_dir_path());
+    }();
+    return store.get();
+}
+
+std::unique_ptr<Filer_store> Filer_store::open(QString const& dir_path)
+{
+    return std::unique_ptr<Filer_store>(new Filer_store(dir_path));
+}
+
+Filer_store::Filer_store(QString const& dir_path)
+    : m_dir_path{dir_path}
+    , m_log_path{dir_path + QStringLiteral("store.log")}
+{
+    load();
+}
+
+bool Filer_store::contains(QString const& path) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.find(key(path)) != m_entries.end();
+}
+
+bool Filer_store::read(QString const& path, QVariantMap& info) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.find(key(path));
+    if (it == m_entries.end()) {
+        return false;
+    }
+    info = it->second;
+    return true;
+}
+
+QStringList Filer_store::paths(QString const& dir_path) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto prefix = key(dir_path);
+    if (!prefix.endsWith(QLatin1Char('/'))) {
+        prefix += QLatin1Char('/');
+    }
+    QStringList paths;
+
+    for (auto const& [entry_key, info] : m_entries) {
+        if (entry_key.startsWith(prefix)) {
+            paths << m_dir_path + entry_key;
+        }
+    }
+    return paths;
+}
+
+uint64_t Filer_store::revision(QString const& path) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_revisions.find(key(path));
+    return it == m_revisions.end() ? 0 : it->second;
+}
+
+bool Filer_store::write(QString const& path, QVariantMap const& info)
+{
+    if (info.isEmpty()) {
+        return remove(path);
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    auto const entry_key = key(path);
+    if (auto it = m_entries.find(entry_key); it != m_entries.end() && it->second == info) {
+        return true;
+    }
+
+    m_entries[entry_key] = info;
+    m_revisions[entry_key] = ++m_revision;
+    return append(entry_key, QCborMap::fromVariantMap(info));
+}
+
+bool Filer_store::remove(QString const& path)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto const entry_key = key(path);
+    if (m_entries.erase(entry_key) == 0) {
+        return true;
+    }
+    m_revisions[entry_key] = ++m_revision;
+    return append(entry_key, QCborValue(nullptr));
+}
+
+bool Filer_store::rename(QString const& from, QString const& to)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto const from_key = key(from);
+    auto it = m_entries.find(from_key);
+    if (it == m_entries.end()) {
+        return false;
+    }
+
+    auto const to_key = key(to);
+    auto const info = it->second;
+    m_entries.erase(it);
+    m_entries[to_key] = info;
+    m_revisions[from_key] = ++m_revision;
+    m_revisions[to_key] = ++m_revision;
+
+    return append(to_key, QCborMap::fromVariantMap(info)) && append(from_key, QCborValue(nullptr));
+}
+
+bool Filer_store::compact()
+{
+    QMutexLocker locker(&m_mutex);
+    return compact_locked();
+}
+
+qint64 Filer_store::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return QFileInfo(m_log_path).size();
+}
+
+void Filer_store::load()
+{
+    QFile file(m_log_path);
+    if (!file.exists()) {
+        import_directories();
+        return;
+    }
+
+    if (!file.open(QIODevice::ReadWrite)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to open control store." << file.errorString();
+        return;
+    }
+
+    auto const data = file.readAll();
+    if (data.size() < header_size || !data.startsWith(encode_header())) {
+        qCWarning(DISMAN_BACKEND) << "Control store" << m_log_path
+                                  << "has an unknown format. Moving it aside.";
+        file.close();
+        QFile::remove(m_log_path + QStringLiteral(".unknown"));
+        QFile::rename(m_log_path, m_log_path + QStringLiteral(".unknown"));
+        import_directories();
+        return;
+    }
+
+    qsizetype offset = header_size;
+    while (offset + 4 <= data.size()) {
+        auto const size = qFromLittleEndian<quint32>(data.constData() + offset);
+        if (size > static_cast<quint32>(data.size() - offset - 4)) {
+            break;
+        }
+
+        auto const record
+            = QCborValue::fromCbor(QByteArray::fromRawData(data.constData() + offset + 4,
+                                                           static_cast<qsizetype>(size)))
+                  .toArray();
+        if (record.size() != 2 || !record.at(0).isString()) {
+            break;
+        }
+
+        auto const entry_key = record.at(0).toString();
+        if (record.at(1).isMap()) {
+            m_entries[entry_key] = record.at(1).toMap().toVariantMap();
+        } else {
+            m_entries.erase(entry_key);
+        }
+
+        m_record_count++;
+        offset += 4 + static_cast<qsizetype>(size);
+    }
+
+    if (offset != data.size()) {
+        // Most likely the process was stopped while appending. Drop the incomplete record.
+        qCWarning(DISMAN_BACKEND) << "Control store" << m_log_path << "has a broken record at"
+                                  << offset << "- truncating it.";
+        file.resize(offset);
+    }
+
+    qCDebug(DISMAN_BACKEND) << "Control store loaded with" << m_entries.size() << "entries from"
+                            << m_record_count << "records.";
+}
+
+void Filer_store::import_directories()
+{
+    for (auto const& sub_dir : {QStringLiteral("configs"), QStringLiteral("outputs")}) {
+        QDir const dir(m_dir_path + sub_dir);
+        auto const infos = dir.entryInfoList({QStringLiteral("*.json")}, QDir::Files);
+
+        for (auto const& info : infos) {
+            QFile file(info.filePath());
+            if (!file.open(QIODevice::ReadOnly)) {
+                qCWarning(DISMAN_BACKEND)
+                    << "Failed to import control file" << info.filePath() << file.errorString();
+                continue;
+            }
+            auto const content = QJsonDocument::fromJson(file.readAll()).toVariant().toMap();
+            if (!content.isEmpty()) {
+                m_entries[key(info.filePath())] = content;
+            }
+        }
+    }
+
+    qCDebug(DISMAN_BACKEND) << "Imported" << m_entries.size() << "control files into"
+                            << m_log_path;
+
+    // Also writes an empty log, so the import is not repeated.
+    compact_locked();
+}
+
+bool Filer_store::append(QString const& key, QCborValue const& value)
+{
+    if (!QDir().mkpath(m_dir_path)) {
+        return false;
+    }
+
+    QFile file(m_log_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to open control store for writing."
+                                  << file.errorString();
+        return false;
+    }
+
+    auto data = encode_record(key, value);
+    if (file.size() == 0) {
+        data.prepend(encode_header());
+    }
+    if (file.write(data) != data.size()) {
+        qCWarning(DISMAN_BACKEND) << "Failed to write to control store." << file.errorString();
+        return false;
+    }
+    file.close();
+
+    m_record_count++;
+    if (m_record_count > 2 * m_entries.size() + compaction_slack) {
+        compact_locked();
+    }
+    return true;
+}
+
+bool Filer_store::compact_locked()
+{
+    if (!QDir().mkpath(m_dir_path)) {
+        return false;
+    }
+
+    QSaveFile file(m_log_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to open control store for compaction."
+                                  << file.errorString();
+        return false;
+    }
+
+    file.write(encode_header());
+    for (auto const& [entry_key, info] : m_entries) {
+        file.write(encode_record(entry_key, QCborMap::fromVariantMap(info)));
+    }
+    if (!file.commit()) {
+        qCWarning(DISMAN_BACKEND) << "Failed to compact control store." << file.errorString();
+        return false;
+    }
+
+    qCDebug(DISMAN_BACKEND) << "Control store compacted from" << m_record_count << "to"
+                            << m_entries.size() << "records.";
+    m_record_count = m_entries.size();
+    return true;
+}
+
+QString Filer_store::key(QString const& path) const
+{
+    return QDir(m_dir_path).relativeFilePath(path);
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include <QCborValue>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+
+namespace Disman
+{
+
+/**
+ * Optional storage engine for control files keeping all of them in a single append-only log.
+ *
+ * It is enabled by setting the environment variable DISMAN_CONTROL_STORE to "log". Control files
+ * are then identified by their path relative to the control directory, but no file in the
+ * configs and outputs directories is read or written anymore.
+ *
+ * The log is read in once. Every change appends a record, and removals append a record without
+ * content. When the log contains considerably more records than live entries it is compacted by
+ * replacing it with one record per live entry.
+ *
+ * When no log exists yet, the control files in the configs and outputs directories are imported.
+ * The files themselves are left in place.
+ */
+class Filer_store
+{
+public:
+    /**
+     * The store or null if it is not enabled.
+     */
+    static Filer_store* instance();
+
+    /**
+     * Opens the store of the control directory at @p dir_path independent of the environment.
+     */
+    static std::unique_ptr<Filer_store> open(QString const& dir_path);
+
+    bool contains(QString const& path) const;
+    bool read(QString const& path, QVariantMap& info) const;
+
+    /**
+     * The paths of the control files in the directory at @p dir_path.
+     */
+    QStringList paths(QString const& dir_path) const;
+
+    /**
+     * Identifies the state of the control file at @p path. It changes with every write, removal or
+     * rename of the file and is zero while the file was not changed since the store was opened.
+     */
+    uint64_t revision(QString const& path) const;
+
+    /**
+     * Writes @p info to the control file at @p path. An empty @p info removes it.
+     */
+    bool write(QString const& path, QVariantMap const& info);
+    bool remove(QString const& path);
+    bool rename(QString const& from, QString const& to);
+
+    bool compact();
+
+    /**
+     * The size of the log on disk in bytes.
+     */
+    qint64 size() const;
+
+private:
+    explicit Filer_store(QString const& dir_path);
+
+    void load();
+    void import_directories();
+    bool append(QString const& key, QCborValue const& value);
+    bool compact_locked();
+    QString key(QString const& path) const;
+
+    QString m_dir_path;
+    QString m_log_path;
+
+    mutable QMutex m_mutex;
+    std::map<QString, QVariantMap> m_entries;
+
+    // Keys changed since the store was opened with the revision of their last change.
+    std::map<QString, uint64_t> m_revisions;
+    uint64_t m_revision{0};
+
+    // Records in the log, including outdated ones.
+    size_t m_record_count{0};
+};
+
+}
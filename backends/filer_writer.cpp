@@ -0,0 +1,124 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "filer_writer.h"
+
+#include "filer_helpers.h"
+#include "logging.h"
+
+#include <QFileInfo>
+
+namespace Disman
+{
+
+Filer_writer::Filer_writer(QObject* parent)
+    : QObject(parent)
+    , m_worker{new QObject}
+{
+    // Long enough to catch the writes of a mode switch and a following config change from the
+    // windowing system.
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(500);
+    connect(&m_timer, &QTimer::timeout, this, &Filer_writer::dispatch);
+
+    m_thread.setObjectName(QStringLiteral("Disman control writer"));
+    m_worker->moveToThread(&m_thread);
+    m_thread.start();
+}
+
+Filer_writer::~Filer_writer()
+{
+    flush();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void Filer_writer::write(QString const& path, QVariantMap const& content)
+{
+    m_pending[path] = content;
+
+    // Not restarted on later writes, so a constant stream of writes can not starve the disk.
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+void Filer_writer::flush()
+{
+    m_timer.stop();
+    dispatch();
+
+    if (m_batches_in_flight == 0) {
+        return;
+    }
+
+    // The worker processes batches in order, so once this returns all previous ones are done.
+    QMetaObject::invokeMethod(m_worker.get(), [] {}, Qt::BlockingQueuedConnection);
+}
+
+void Filer_writer::schedule(std::function<void()> task)
+{
+    m_timer.stop();
+    dispatch();
+
+    m_batches_in_flight++;
+    QMetaObject::invokeMethod(
+        m_worker.get(),
+        [this, task = std::move(task)] {
+            task();
+            m_batches_in_flight--;
+        },
+        Qt::QueuedConnection);
+}
+
+void Filer_writer::call_when_written(std::function<void()> callback)
+{
+    m_pending_callbacks.push_back(std::move(callback));
+
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+void Filer_writer::dispatch()
+{
+    if (m_pending.empty() && m_pending_callbacks.empty()) {
+        return;
+    }
+
+    auto jobs = std::move(m_pending);
+    m_pending.clear();
+    auto callbacks = std::move(m_pending_callbacks);
+    m_pending_callbacks.clear();
+
+    m_batches_in_flight++;
+    QMetaObject::invokeMethod(
+        m_worker.get(),
+        [this, jobs = std::move(jobs), callbacks = std::move(callbacks)] {
+            run(jobs);
+            m_batches_in_flight--;
+
+            if (!callbacks.empty()) {
+                QMetaObject::invokeMethod(
+                    this,
+                    [callbacks] {
+                        for (auto const& callback : callbacks) {
+                            callback();
+                        }
+                    },
+                    Qt::QueuedConnection);
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void Filer_writer::run(std::map<QString, QVariantMap> const& jobs)
+{
+    for (auto const& [path, content] : jobs) {
+        Filer_helpers::write_file(content, QFileInfo(path));
+    }
+}
+
+}
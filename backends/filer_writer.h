@@ -0,0 +1,72 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <QVariantMap>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace Disman
+{
+
+/**
+ * Writes control files on a worker thread.
+ *
+ * Writes are collected for a short time before they are handed to the worker. Writing the same
+ * file again in this time replaces the earlier content, so only the last state hits the disk.
+ * Files are replaced atomically.
+ *
+ * Everything reading control files or moving them around must call flush() first.
+ */
+class Filer_writer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Filer_writer(QObject* parent = nullptr);
+    ~Filer_writer() override;
+
+    /**
+     * Queues writing @p content to the file at @p path. An empty @p content removes the file.
+     */
+    void write(QString const& path, QVariantMap const& content);
+
+    /**
+     * Blocks until all queued writes are on disk.
+     */
+    void flush();
+
+    /**
+     * Runs @p task on the worker thread after all writes queued so far.
+     */
+    void schedule(std::function<void()> task);
+
+    /**
+     * Calls @p callback on the thread of this object once the writes queued so far are on disk.
+     */
+    void call_when_written(std::function<void()> callback);
+
+private:
+    void dispatch();
+    static void run(std::map<QString, QVariantMap> const& jobs);
+
+    std::map<QString, QVariantMap> m_pending;
+    std::vector<std::function<void()>> m_pending_callbacks;
+    QTimer m_timer;
+
+    QThread m_thread;
+    std::unique_ptr<QObject> m_worker;
+    std::atomic<int> m_batches_in_flight{0};
+};
+
+}
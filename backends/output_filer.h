@@ -19,6 +19,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "filer_controller.h"
 #include "filer_helpers.h"
+#include "filer_writer.h"
 
 #include <output.h>
 #include <types.h>
@@ -42,6 +43,15 @@ public:
         read_file();
     }
 
+    /**
+     * Creates a filer for @p output without a control file. Values are only held in memory.
+     */
+    explicit Output_filer(OutputPtr output)
+        : m_output(output)
+        , m_controller(nullptr)
+    {
+    }
+
     OutputPtr output() const
     {
         return m_output;
@@ -149,10 +159,8 @@ public:
             return default_value;
         }
 
-        for (auto const& [key, mode] : output->modes()) {
-            if (mode->size() == resolution && mode->refresh() == refresh) {
-                return mode;
-            }
+        if (auto mode = output->mode(resolution, refresh)) {
+            return mode;
         }
         return default_value;
     }
@@ -182,9 +190,9 @@ public:
         Filer_helpers::read_file(file_info(), m_info);
     }
 
-    bool write_file()
+    void write_file()
     {
-        return Filer_helpers::write_file(m_info, file_info());
+        m_controller->writer()->write(file_info().filePath(), m_info);
     }
 
     void get_global_data(OutputPtr& output)
@@ -239,7 +239,7 @@ bool WaylandInterface::apply_config_impl(const Disman::ConfigPtr& newConfig, boo
         return true;
     }
 
-    for (auto const& [key, output] : newConfig->outputs()) {
+    for (auto const& [key, output] : newConfig->output_map()) {
         changed |= m_outputMap[output->id()]->setWlConfig(wlConfig, output);
     }
 
@@ -295,7 +295,7 @@ void WaylandInterface::test_toggle_adaptive_sync(WaylandOutput* output)
     test.config.reset(m_outputManager->createConfiguration());
     test.config->setEventQueue(m_queue);
 
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         m_outputMap[output->id()]->setWlConfig(test.config.get(), output);
     }
 
@@ -111,8 +111,9 @@ void WaylandOutput::updateDismanOutput(OutputPtr& output)
     // Initialize primary output
     output->set_enabled(head.enabled());
     output->set_name(head.name().toStdString());
-    output->set_description(head.description().toStdString());
-    output->set_hash(hash().toStdString());
+    update_identity();
+    output->set_description(m_description);
+    output->set_hash(m_hash);
     output->set_physical_size(head.physicalSize());
     output->set_position(head.position());
     output->set_rotation(toDismanRotation(head.transform()));
@@ -236,13 +237,21 @@ bool WaylandOutput::setWlConfig(Wl::WlrOutputConfigurationV1* wlConfig,
     return changed;
 }
 
-QString WaylandOutput::hash() const
+void WaylandOutput::update_identity()
 {
+    if (!m_hash.empty()) {
+        return;
+    }
+
+    m_description = head.description().toStdString();
+
     if (!head.model().isEmpty()) {
-        return QStringLiteral("%1:%2:%3:%4")
-            .arg(head.make(), head.model(), head.serialNumber(), head.name());
+        m_hash = QStringLiteral("%1:%2:%3:%4")
+                     .arg(head.make(), head.model(), head.serialNumber(), head.name())
+                     .toStdString();
+    } else {
+        m_hash = m_description;
     }
-    return head.description();
 }
 
 QDebug operator<<(QDebug dbg, const WaylandOutput* output)
@@ -55,10 +55,15 @@ Q_SIGNALS:
 
 private:
     void showOutput();
-    QString hash() const;
+    void update_identity();
 
     Wrapland::Client::Registry* m_registry;
 
+    // The identifying head properties are sent only once per head, so these are computed only once
+    // as well.
+    std::string m_description;
+    std::string m_hash;
+
     // left-hand-side: Disman::Mode, right-hand-side: Wrapland's WlrOutputModeV1
     std::map<std::string, Wrapland::Client::WlrOutputModeV1*> m_modeIdMap;
 };
@@ -204,20 +204,31 @@ void XCBEventListener::handleXRandRNotify(xcb_generic_event_t* e)
         qCDebug(DISMAN_XRANDR) << "\tConnection: "
                                << connectionToString((xcb_randr_connection_t)output.connection);
         qCDebug(DISMAN_XRANDR) << "\tSubpixel Order: " << output.subpixel_order;
-        Q_EMIT outputChanged(
-            output.output, output.crtc, output.mode, (xcb_randr_connection_t)output.connection);
+        qCDebug(DISMAN_XRANDR) << "\tConfig timestamp: " << output.config_timestamp;
+        Q_EMIT outputChanged(output.output,
+                             output.crtc,
+                             output.mode,
+                             (xcb_randr_connection_t)output.connection,
+                             output.config_timestamp);
 
     } else if (randrEvent->subCode == XCB_RANDR_NOTIFY_OUTPUT_PROPERTY) {
         xcb_randr_output_property_t property = randrEvent->u.op;
 
-        XCB::ScopedPointer<xcb_get_atom_name_reply_t> reply(
-            xcb_get_atom_name_reply(QX11Info::connection(),
-                                    xcb_get_atom_name(QX11Info::connection(), property.atom),
-                                    nullptr));
-
-        qCDebug(DISMAN_XRANDR) << "RRNotify_OutputProperty (ignored)";
-        qCDebug(DISMAN_XRANDR) << "\tOutput: " << property.output;
-        qCDebug(DISMAN_XRANDR) << "\tProperty: " << xcb_get_atom_name_name(reply.data());
-        qCDebug(DISMAN_XRANDR) << "\tState (newValue, Deleted): " << property.status;
+        if (DISMAN_XRANDR().isDebugEnabled()) {
+            // Only look up the name when it is printed since this is a round trip.
+            XCB::ScopedPointer<xcb_get_atom_name_reply_t> reply(
+                xcb_get_atom_name_reply(QX11Info::connection(),
+                                        xcb_get_atom_name(QX11Info::connection(), property.atom),
+                                        nullptr));
+
+            qCDebug(DISMAN_XRANDR) << "RRNotify_OutputProperty";
+            qCDebug(DISMAN_XRANDR) << "\tOutput: " << property.output;
+            qCDebug(DISMAN_XRANDR)
+                << "\tProperty: "
+                << QByteArray(xcb_get_atom_name_name(reply.data()),
+                              xcb_get_atom_name_name_length(reply.data()));
+            qCDebug(DISMAN_XRANDR) << "\tState (newValue, Deleted): " << property.status;
+        }
+        Q_EMIT outputPropertyChanged(property.output, property.atom);
     }
 }
@@ -45,8 +45,9 @@ Q_SIGNALS:
     void outputChanged(xcb_randr_output_t output,
                        xcb_randr_crtc_t crtc,
                        xcb_randr_mode_t mode,
-                       xcb_randr_connection_t connection);
-    void outputPropertyChanged(xcb_randr_output_t output);
+                       xcb_randr_connection_t connection,
+                       xcb_timestamp_t configTimestamp);
+    void outputPropertyChanged(xcb_randr_output_t output, xcb_atom_t atom);
 
 private:
     QString rotationToString(xcb_randr_rotation_t rotation);
@@ -20,7 +20,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "xcbwrapper.h"
 
+#include "xrandr_logging.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+#include <xcb/xcbext.h>
+
 static xcb_connection_t* sXRandR11XCBConnection = nullptr;
+static uint64_t sRoundTrips = 0;
+static XCB::Atoms sAtoms;
+static bool sAtomsInitialized = false;
 
 xcb_connection_t* XCB::connection()
 {
@@ -62,3 +73,92 @@ XCB::GrabServer::~GrabServer()
     xcb_ungrab_server(connection());
     xcb_flush(connection());
 }
+
+void* XCB::waitForReply(unsigned int sequence)
+{
+    void* reply = nullptr;
+    xcb_generic_error_t* error = nullptr;
+
+    if (!xcb_poll_for_reply(connection(), sequence, &reply, &error)) {
+        sRoundTrips++;
+        reply = xcb_wait_for_reply(connection(), sequence, &error);
+    }
+
+    if (error) {
+        qCDebug(DISMAN_XRANDR) << "XCB request" << sequence << "failed with error code"
+                               << error->error_code;
+        free(error);
+    }
+    return reply;
+}
+
+uint64_t XCB::roundTrips()
+{
+    return sRoundTrips;
+}
+
+void XCB::initAtoms()
+{
+    if (sAtomsInitialized) {
+        return;
+    }
+
+    const std::array<std::pair<xcb_atom_t*, const char*>, 5> names{{
+        {&sAtoms.edid, "EDID"},
+        {&sAtoms.edidData, "EDID_DATA"},
+        {&sAtoms.xfree86Edid, "XFree86_DDC_EDID1_RAWDATA"},
+        {&sAtoms.hotplugModeUpdate, "hotplug_mode_update"},
+        {&sAtoms.connectorType, "ConnectorType"},
+    }};
+
+    // Send all requests before waiting for the first reply.
+    std::array<InternAtom, names.size()> requests;
+    for (size_t i = 0; i < names.size(); ++i) {
+        requests[i] = InternAtom(false, strlen(names[i].second), names[i].second);
+    }
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (requests[i]) {
+            *names[i].first = requests[i]->atom;
+        }
+    }
+
+    sAtomsInitialized = true;
+}
+
+const XCB::Atoms& XCB::atoms()
+{
+    initAtoms();
+    return sAtoms;
+}
+
+XCB::OutputEdid::OutputEdid(xcb_randr_output_t output)
+{
+    auto request = [output](xcb_atom_t atom) {
+        if (atom == XCB_ATOM_NONE) {
+            return OutputProperty();
+        }
+        return OutputProperty(output, atom, XCB_ATOM_ANY, 0, 100, false, false);
+    };
+
+    m_edid = request(atoms().edid);
+    m_edidData = request(atoms().edidData);
+    m_xfree86Edid = request(atoms().xfree86Edid);
+}
+
+QByteArray XCB::OutputEdid::edid() const
+{
+    for (auto property : {&m_edid, &m_edidData, &m_xfree86Edid}) {
+        const xcb_randr_get_output_property_reply_t* reply = *property;
+        if (!reply || reply->type != XCB_ATOM_INTEGER || reply->format != 8) {
+            continue;
+        }
+        if (reply->num_items % 128 != 0) {
+            // Only the first property with the right format is considered.
+            return QByteArray();
+        }
+        return QByteArray(
+            reinterpret_cast<const char*>(xcb_randr_get_output_property_data(reply)),
+            reply->num_items);
+    }
+    return QByteArray();
+}
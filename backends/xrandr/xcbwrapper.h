@@ -20,9 +20,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <type_traits>
 
+#include <QByteArray>
 #include <QScopedPointer>
 
 #include <xcb/randr.h>
@@ -43,6 +45,35 @@ struct GrabServer {
     ~GrabServer();
 };
 
+/**
+ * Atoms used by the backend. These are interned only once for the whole process.
+ */
+struct Atoms {
+    xcb_atom_t edid{XCB_ATOM_NONE};
+    xcb_atom_t edidData{XCB_ATOM_NONE};
+    xcb_atom_t xfree86Edid{XCB_ATOM_NONE};
+    xcb_atom_t hotplugModeUpdate{XCB_ATOM_NONE};
+    xcb_atom_t connectorType{XCB_ATOM_NONE};
+};
+
+/**
+ * Interns all atoms at once. Does nothing if they were interned before.
+ */
+void initAtoms();
+const Atoms& atoms();
+
+/**
+ * Waits for the reply to the request with @p sequence. Returns the reply or null on error.
+ */
+void* waitForReply(unsigned int sequence);
+
+/**
+ * The number of times a reply had not arrived yet when it was needed, so the X server had to be
+ * waited for. Replies to requests sent before arrive together, so this approximates the round
+ * trips taken. Only replies retrieved through the wrappers below are counted.
+ */
+uint64_t roundTrips();
+
 template<typename Reply,
          typename Cookie,
          typename ReplyFunc,
@@ -149,7 +180,8 @@ protected:
         if (m_retrieved || !m_cookie.sequence) {
             return;
         }
-        m_reply = replyFunc(connection(), m_cookie, nullptr);
+        // Same as replyFunc but counting round trips.
+        m_reply = static_cast<Reply*>(waitForReply(m_cookie.sequence));
         m_retrieved = true;
     }
 
@@ -209,6 +241,43 @@ XCB_DECLARE_TYPE(OutputInfo, xcb_randr_get_output_info, xcb_randr_output_t, xcb_
 
 XCB_DECLARE_TYPE(CRTCInfo, xcb_randr_get_crtc_info, xcb_randr_crtc_t, xcb_timestamp_t);
 
+XCB_DECLARE_TYPE(CRTCTransform, xcb_randr_get_crtc_transform, xcb_randr_crtc_t);
+
 XCB_DECLARE_TYPE(AtomName, xcb_get_atom_name, xcb_atom_t);
 
+XCB_DECLARE_TYPE(ScreenResources, xcb_randr_get_screen_resources, xcb_window_t);
+
+XCB_DECLARE_TYPE(ScreenResourcesCurrent, xcb_randr_get_screen_resources_current, xcb_window_t);
+
+XCB_DECLARE_TYPE(OutputProperty,
+                 xcb_randr_get_output_property,
+                 xcb_randr_output_t,
+                 xcb_atom_t,
+                 xcb_atom_t,
+                 uint32_t,
+                 uint32_t,
+                 uint8_t,
+                 uint8_t);
+
+/**
+ * Requests all properties an EDID might be stored in at once, so the fallbacks do not cost
+ * additional round trips.
+ */
+class OutputEdid
+{
+public:
+    OutputEdid() = default;
+    explicit OutputEdid(xcb_randr_output_t output);
+
+    /**
+     * The EDID of the first property containing a valid one or a null array.
+     */
+    QByteArray edid() const;
+
+private:
+    OutputProperty m_edid;
+    OutputProperty m_edidData;
+    OutputProperty m_xfree86Edid;
+};
+
 }
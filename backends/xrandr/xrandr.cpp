@@ -57,6 +57,8 @@ XRandR::XRandR()
     qRegisterMetaType<xcb_randr_mode_t>("xcb_randr_mode_t");
     qRegisterMetaType<xcb_randr_connection_t>("xcb_randr_connection_t");
     qRegisterMetaType<xcb_randr_rotation_t>("xcb_randr_rotation_t");
+    qRegisterMetaType<xcb_atom_t>("xcb_atom_t");
+    qRegisterMetaType<xcb_timestamp_t>("xcb_timestamp_t");
 
     // Use our own connection to make sure that we won't mess up Qt's connection
     // if something goes wrong on our side.
@@ -86,6 +88,7 @@ XRandR::XRandR()
     if (s_screen == nullptr) {
         s_screen = XCB::screenOfDisplay(XCB::connection(), QX11Info::appScreen());
         s_rootWindow = s_screen->root;
+        XCB::initAtoms();
 
         xcb_prefetch_extension_data(XCB::connection(), &xcb_randr_id);
         auto reply = xcb_get_extension_data(XCB::connection(), &xcb_randr_id);
@@ -107,6 +110,11 @@ XRandR::XRandR()
                 this,
                 &XRandR::outputChanged,
                 Qt::QueuedConnection);
+        connect(m_x11Helper,
+                &XCBEventListener::outputPropertyChanged,
+                this,
+                &XRandR::outputPropertyChanged,
+                Qt::QueuedConnection);
         connect(m_x11Helper,
                 &XCBEventListener::crtcChanged,
                 this,
@@ -146,7 +154,8 @@ QString XRandR::service_name() const
 void XRandR::outputChanged(xcb_randr_output_t output,
                            xcb_randr_crtc_t crtc,
                            xcb_randr_mode_t mode,
-                           xcb_randr_connection_t connection)
+                           xcb_randr_connection_t connection,
+                           xcb_timestamp_t configTimestamp)
 {
     m_configChangeCompressor->start();
 
@@ -166,12 +175,30 @@ void XRandR::outputChanged(xcb_randr_output_t output,
         return;
     }
 
-    XCB::PrimaryOutput primary(XRandR::rootWindow());
-    xOutput->update(crtc, mode, connection, (primary->output == output));
+    xOutput->updateFromNotify(crtc, mode, connection, configTimestamp);
+
+    // Changes of the primary output are notified as output changes too, but without the primary
+    // state. Query it only once when the config is read next instead of on every notification.
+    s_internalConfig->invalidatePrimary();
+
     qCDebug(DISMAN_XRANDR) << "Output" << xOutput->id() << ": connected =" << xOutput->isConnected()
                            << ", enabled =" << xOutput->enabled();
 }
 
+void XRandR::outputPropertyChanged(xcb_randr_output_t output, xcb_atom_t atom)
+{
+    const auto& atoms = XCB::atoms();
+    if (atom != atoms.edid && atom != atoms.edidData && atom != atoms.xfree86Edid) {
+        return;
+    }
+
+    if (auto xOutput = s_internalConfig->output(output)) {
+        // The hash is derived from the EDID, so the output might be a different one now.
+        xOutput->invalidateEdid();
+        m_configChangeCompressor->start();
+    }
+}
+
 void XRandR::crtcChanged(xcb_randr_crtc_t crtc,
                          xcb_randr_mode_t mode,
                          xcb_randr_rotation_t rotation,
@@ -207,12 +234,17 @@ void XRandR::screenChanged(xcb_randr_rotation_t rotation,
 
 void XRandR::update_config(ConfigPtr& config) const
 {
+    s_internalConfig->updatePrimary();
     s_internalConfig->update_config(config);
 }
 
 bool XRandR::set_config_system(Disman::ConfigPtr const& config)
 {
-    return s_internalConfig->applyDismanConfig(config);
+    bool changed;
+    if (!s_internalConfig->applyDismanConfig(config, changed)) {
+        config_system_failed();
+    }
+    return changed;
 }
 
 bool XRandR::valid() const
@@ -220,64 +252,19 @@ bool XRandR::valid() const
     return m_valid;
 }
 
-quint8* XRandR::getXProperty(xcb_randr_output_t output, xcb_atom_t atom, size_t& len)
-{
-    quint8* result;
-
-    auto cookie = xcb_randr_get_output_property(
-        XCB::connection(), output, atom, XCB_ATOM_ANY, 0, 100, false, false);
-    auto reply = xcb_randr_get_output_property_reply(XCB::connection(), cookie, nullptr);
-
-    if (reply->type == XCB_ATOM_INTEGER && reply->format == 8) {
-        result = new quint8[reply->num_items];
-        memcpy(result, xcb_randr_get_output_property_data(reply), reply->num_items);
-        len = reply->num_items;
-    } else {
-        result = nullptr;
-    }
-
-    free(reply);
-    return result;
-}
-
 QByteArray XRandR::outputEdid(xcb_randr_output_t outputId)
 {
-    size_t len = 0;
-    quint8* result;
-
-    auto edid_atom = XCB::InternAtom(false, 4, "EDID")->atom;
-    result = XRandR::getXProperty(outputId, edid_atom, len);
-    if (result == nullptr) {
-        auto edid_atom = XCB::InternAtom(false, 9, "EDID_DATA")->atom;
-        result = XRandR::getXProperty(outputId, edid_atom, len);
-    }
-    if (result == nullptr) {
-        auto edid_atom = XCB::InternAtom(false, 25, "XFree86_DDC_EDID1_RAWDATA")->atom;
-        result = XRandR::getXProperty(outputId, edid_atom, len);
-    }
-
-    QByteArray edid;
-    if (result != nullptr) {
-        if (len % 128 == 0) {
-            edid = QByteArray(reinterpret_cast<const char*>(result), len);
-        }
-        delete[] result;
-    }
-    return edid;
+    return XCB::OutputEdid(outputId).edid();
 }
 
-bool XRandR::hasProperty(xcb_randr_output_t output, const QByteArray& name)
+bool XRandR::hasProperty(xcb_randr_output_t output, xcb_atom_t atom)
 {
-    xcb_generic_error_t* error = nullptr;
-    auto atom = XCB::InternAtom(false, name.length(), name.constData())->atom;
-
-    auto cookie = xcb_randr_get_output_property(
-        XCB::connection(), output, atom, XCB_ATOM_ANY, 0, 1, false, false);
-    auto prop_reply = xcb_randr_get_output_property_reply(XCB::connection(), cookie, &error);
+    if (atom == XCB_ATOM_NONE) {
+        return false;
+    }
 
-    const bool ret = prop_reply->num_items == 1;
-    free(prop_reply);
-    return ret;
+    XCB::OutputProperty reply(output, atom, XCB_ATOM_ANY, 0, 1, false, false);
+    return reply && reply->num_items == 1;
 }
 
 xcb_randr_get_screen_resources_reply_t* XRandR::screenResources()
@@ -287,10 +274,7 @@ xcb_randr_get_screen_resources_reply_t* XRandR::screenResources()
             // HACK: This abuses the fact that xcb_randr_get_screen_resources_reply_t
             // and xcb_randr_get_screen_resources_current_reply_t are the same
             return reinterpret_cast<xcb_randr_get_screen_resources_reply_t*>(
-                xcb_randr_get_screen_resources_current_reply(
-                    XCB::connection(),
-                    xcb_randr_get_screen_resources_current(XCB::connection(), XRandR::rootWindow()),
-                    nullptr));
+                XCB::ScreenResourcesCurrent(XRandR::rootWindow()).take());
         } else {
             /* XRRGetScreenResourcesCurrent is faster then XRRGetScreenResources
              * because it returns cached values. However the cached values are not
@@ -300,10 +284,7 @@ xcb_randr_get_screen_resources_reply_t* XRandR::screenResources()
         }
     }
 
-    return xcb_randr_get_screen_resources_reply(
-        XCB::connection(),
-        xcb_randr_get_screen_resources(XCB::connection(), XRandR::rootWindow()),
-        nullptr);
+    return XCB::ScreenResources(XRandR::rootWindow()).take();
 }
 
 xcb_window_t XRandR::rootWindow()
@@ -54,13 +54,15 @@ public:
     static xcb_screen_t* screen();
     static xcb_window_t rootWindow();
 
-    static bool hasProperty(xcb_randr_output_t outputId, const QByteArray& name);
+    static bool hasProperty(xcb_randr_output_t outputId, xcb_atom_t atom);
 
 private:
     void outputChanged(xcb_randr_output_t output,
                        xcb_randr_crtc_t crtc,
                        xcb_randr_mode_t mode,
-                       xcb_randr_connection_t connection);
+                       xcb_randr_connection_t connection,
+                       xcb_timestamp_t configTimestamp);
+    void outputPropertyChanged(xcb_randr_output_t output, xcb_atom_t atom);
     void crtcChanged(xcb_randr_crtc_t crtc,
                      xcb_randr_mode_t mode,
                      xcb_randr_rotation_t rotation,
@@ -68,8 +70,6 @@ private:
     void
     screenChanged(xcb_randr_rotation_t rotation, const QSize& sizePx, const QSize& physical_size);
 
-    static quint8* getXProperty(xcb_randr_output_t output, xcb_atom_t atom, size_t& len);
-
     static xcb_screen_t* s_screen;
     static xcb_window_t s_rootWindow;
     static XRandRConfig* s_internalConfig;
@@ -31,26 +31,97 @@
 
 #include <QRect>
 
+#include <algorithm>
+#include <set>
+#include <tuple>
+#include <vector>
+
 using namespace Disman;
 
 XRandRConfig::XRandRConfig()
     : QObject()
     , m_screen(nullptr)
 {
-    m_screen = new XRandRScreen(this);
+    // All requests of a phase are sent before waiting for the first reply. That way constructing
+    // the config takes one round trip per phase instead of several ones per CRTC and output.
+    XCB::ScreenSize screenSize(XRandR::rootWindow());
+    XCB::PrimaryOutput primary(XRandR::rootWindow());
 
     XCB::ScopedPointer<xcb_randr_get_screen_resources_reply_t> resources(XRandR::screenResources());
 
+    m_screen = new XRandRScreen(screenSize, this);
+
+    Q_ASSERT(resources);
+    if (!resources) {
+        return;
+    }
+
     xcb_randr_crtc_t* crtcs = xcb_randr_get_screen_resources_crtcs(resources.data());
     const int crtcsCount = xcb_randr_get_screen_resources_crtcs_length(resources.data());
+    xcb_randr_output_t* outputs = xcb_randr_get_screen_resources_outputs(resources.data());
+    const int outputsCount = xcb_randr_get_screen_resources_outputs_length(resources.data());
+
+    const auto primaryId = primary ? primary->output : static_cast<xcb_randr_output_t>(XCB_NONE);
+    const auto typeAtomId = XCB::atoms().connectorType;
+    const auto hotplugAtomId = XCB::atoms().hotplugModeUpdate;
+
+    struct OutputReplies {
+        XCB::OutputInfo info;
+        XCB::OutputProperty type;
+        XCB::OutputProperty hotplug;
+        XCB::AtomName typeName;
+        XCB::OutputEdid edid;
+    };
+
+    std::vector<XCB::CRTCInfo> crtcInfos(crtcsCount);
     for (int i = 0; i < crtcsCount; ++i) {
-        addNewCrtc(crtcs[i]);
+        crtcInfos[i] = XCB::CRTCInfo(crtcs[i], XCB_TIME_CURRENT_TIME);
+    }
+
+    std::vector<OutputReplies> outputReplies(outputsCount);
+    for (int i = 0; i < outputsCount; ++i) {
+        auto& replies = outputReplies[i];
+        replies.info = XCB::OutputInfo(outputs[i], XCB_TIME_CURRENT_TIME);
+        if (typeAtomId != XCB_ATOM_NONE) {
+            replies.type
+                = XCB::OutputProperty(outputs[i], typeAtomId, XCB_ATOM_ANY, 0, 100, false, false);
+        }
+        if (hotplugAtomId != XCB_ATOM_NONE) {
+            replies.hotplug
+                = XCB::OutputProperty(outputs[i], hotplugAtomId, XCB_ATOM_ANY, 0, 1, false, false);
+        }
+    }
+
+    // The connector types are atoms whose names must be requested in another phase. Request the
+    // EDIDs of connected outputs in this phase too.
+    for (int i = 0; i < outputsCount; ++i) {
+        auto& replies = outputReplies[i];
+        if (const auto atom = XRandROutput::typeAtom(replies.type); atom != XCB_ATOM_NONE) {
+            replies.typeName = XCB::AtomName(atom);
+        }
+        if (replies.info && replies.info->connection == XCB_RANDR_CONNECTION_CONNECTED) {
+            replies.edid = XCB::OutputEdid(outputs[i]);
+        }
+    }
+
+    for (int i = 0; i < crtcsCount; ++i) {
+        m_crtcs.insert({crtcs[i], new XRandRCrtc(crtcs[i], crtcInfos[i], this)});
     }
 
-    xcb_randr_output_t* outputs = xcb_randr_get_screen_resources_outputs(resources.data());
-    const int outputsCount = xcb_randr_get_screen_resources_outputs_length(resources.data());
     for (int i = 0; i < outputsCount; ++i) {
-        addNewOutput(outputs[i]);
+        const auto& replies = outputReplies[i];
+        if (!replies.info) {
+            qCWarning(DISMAN_XRANDR) << "Failed to query output" << outputs[i];
+            continue;
+        }
+
+        const XRandROutput::InitData data{replies.info,
+                                          resources.data(),
+                                          primaryId,
+                                          XRandROutput::typeName(replies.typeName),
+                                          replies.hotplug && replies.hotplug->num_items == 1,
+                                          replies.edid.edid()};
+        m_outputs.insert({outputs[i], new XRandROutput(outputs[i], data, this)});
     }
 }
 
@@ -116,6 +187,26 @@ void XRandRConfig::removeOutput(xcb_randr_output_t id)
     }
 }
 
+void XRandRConfig::invalidatePrimary()
+{
+    m_primaryOutdated = true;
+}
+
+void XRandRConfig::updatePrimary()
+{
+    if (!m_primaryOutdated) {
+        return;
+    }
+    m_primaryOutdated = false;
+
+    XCB::PrimaryOutput primary(XRandR::rootWindow());
+    const auto primaryId = primary ? primary->output : static_cast<xcb_randr_output_t>(XCB_NONE);
+
+    for (auto const& [key, output] : m_outputs) {
+        output->setIsPrimary(output->id() == primaryId);
+    }
+}
+
 Disman::ConfigPtr XRandRConfig::update_config(Disman::ConfigPtr& config) const
 {
     const Config::Features features = Config::Feature::Writable | Config::Feature::PrimaryDisplay
@@ -146,9 +237,10 @@ Disman::ConfigPtr XRandRConfig::update_config(Disman::ConfigPtr& config) const
     return config;
 }
 
-bool XRandRConfig::applyDismanConfig(const Disman::ConfigPtr& config)
+bool XRandRConfig::applyDismanConfig(const Disman::ConfigPtr& config, bool& changed)
 {
-    auto const dismanOutputs = config->outputs();
+    changed = false;
+    auto const& dismanOutputs = config->output_map();
 
     const QSize newScreenSize = screenSize(config);
     const QSize currentScreenSize = m_screen->currentSize();
@@ -168,6 +260,8 @@ bool XRandRConfig::applyDismanConfig(const Disman::ConfigPtr& config)
     xcb_randr_output_t primaryOutput = 0;
     xcb_randr_output_t oldPrimaryOutput = 0;
 
+    // The primary flags of the outputs might be outdated since the last change notification.
+    updatePrimary();
     for (auto const& [key, xrandrOutput] : m_outputs) {
         if (xrandrOutput->isPrimary()) {
             oldPrimaryOutput = xrandrOutput->id();
@@ -328,49 +422,38 @@ bool XRandRConfig::applyDismanConfig(const Disman::ConfigPtr& config)
         if (newScreenSize != currentScreenSize) {
             setScreenSize(newScreenSize);
         }
-        return false;
+        return true;
     }
 
-    for (auto const& [key, output] : toDisable) {
-        disableOutput(output);
+    std::vector<CrtcConfig> crtcConfigs;
+    if (!planCrtcConfigs(toDisable, toChange, toEnable, crtcConfigs)) {
+        return false;
     }
 
+    // The intermediate size fits the current as well as the new configuration, so it can be set
+    // before any CRTC is changed.
     if (intermediateScreenSize != currentScreenSize) {
         setScreenSize(intermediateScreenSize);
     }
 
-    bool forceScreenSizeUpdate = false;
-
-    for (auto const& [key, output] : toChange) {
-        if (!changeOutput(output, output->id() == static_cast<int>(primaryOutput))) {
-            /* If we disabled the output before changing it and XRandR failed
-             * to re-enable it, then update screen size too */
-            if (toDisable.find(output->id()) != toDisable.end()) {
-                output->set_enabled(false);
-                qCDebug(DISMAN_XRANDR) << "Output failed to change: " << output->name().c_str();
-                forceScreenSizeUpdate = true;
-            }
-        }
-    }
-
-    for (auto const& [key, output] : toEnable) {
-        if (!enableOutput(output, output->id() == static_cast<int>(primaryOutput))) {
-            qCDebug(DISMAN_XRANDR) << "Output failed to be Enabled: " << output->name().c_str();
-            forceScreenSizeUpdate = true;
+    changed = true;
+    auto const results = setCrtcConfigs(crtcConfigs);
+    if (std::any_of(results.cbegin(), results.cend(), [](auto const& result) {
+            return !result.success();
+        })) {
+        // The CRTCs have been set back to their previous configs.
+        if (intermediateScreenSize != currentScreenSize) {
+            setScreenSize(currentScreenSize);
         }
+        return false;
     }
 
     if (oldPrimaryOutput != primaryOutput) {
         setPrimaryOutput(primaryOutput);
     }
 
-    if (forceScreenSizeUpdate || intermediateScreenSize != newScreenSize) {
-        QSize newSize = newScreenSize;
-        if (forceScreenSizeUpdate) {
-            newSize = screenSize(config);
-            qCDebug(DISMAN_XRANDR) << "Forced to change screen size: " << newSize;
-        }
-        setScreenSize(newSize);
+    if (intermediateScreenSize != newScreenSize) {
+        setScreenSize(newScreenSize);
     }
 
     return true;
@@ -400,7 +483,7 @@ void XRandRConfig::printConfig(const ConfigPtr& config) const
                                    ? std::to_string(config->primary_output()->id()).c_str()
                                    : "none");
 
-    auto const outputs = config->outputs();
+    auto const& outputs = config->output_map();
     for (auto const& [key, output] : outputs) {
         qCDebug(DISMAN_XRANDR) << "\n-----------------------------------------------------\n"
                                << "\n"
@@ -426,7 +509,7 @@ void XRandRConfig::printConfig(const ConfigPtr& config) const
         }
 
         qCDebug(DISMAN_XRANDR) << "Modes: ";
-        for (auto const& [key, mode] : output->modes()) {
+        for (auto const& [key, mode] : output->mode_map()) {
             qCDebug(DISMAN_XRANDR) << "\t" << mode->id().c_str() << "  " << mode->name().c_str()
                                    << " " << mode->size() << " " << mode->refresh();
         }
@@ -459,7 +542,7 @@ void XRandRConfig::printInternalCond() const
 QSize XRandRConfig::screenSize(const Disman::ConfigPtr& config) const
 {
     QRect rect;
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         if (!output->enabled()) {
             continue;
         }
@@ -514,160 +597,277 @@ void XRandRConfig::setPrimaryOutput(xcb_randr_output_t outputId) const
     }
 }
 
-bool XRandRConfig::disableOutput(const OutputPtr& dismanOutput) const
+namespace
 {
-    XRandROutput* xOutput = output(dismanOutput->id());
-    Q_ASSERT(xOutput);
-    Q_ASSERT(xOutput->crtc());
 
-    if (!xOutput->crtc()) {
-        qCWarning(DISMAN_XRANDR) << "Attempting to disable output without CRTC, wth?";
-        return false;
-    }
+/**
+ * Sends all @p configs before waiting for the first reply. Returns the status of each request.
+ */
+std::vector<int> sendCrtcConfigs(const std::vector<const XRandRConfig::CrtcConfig*>& configs)
+{
+    struct Cookies {
+        xcb_void_cookie_t transform;
+        xcb_randr_set_crtc_config_cookie_t config;
+    };
 
-    const xcb_randr_crtc_t crtc = xOutput->crtc()->crtc();
+    auto connection = XCB::connection();
+    std::vector<Cookies> cookies;
+    cookies.reserve(configs.size());
 
-    qCDebug(DISMAN_XRANDR) << "RRSetCrtcConfig (disable output)"
-                           << "\n"
-                           << "\tCRTC:" << crtc;
-
-    auto cookie = xcb_randr_set_crtc_config(XCB::connection(),
-                                            crtc,
-                                            XCB_CURRENT_TIME,
-                                            XCB_CURRENT_TIME,
-                                            0,
-                                            0,
-                                            XCB_NONE,
-                                            XCB_RANDR_ROTATION_ROTATE_0,
-                                            0,
-                                            nullptr);
-
-    XCB::ScopedPointer<xcb_randr_set_crtc_config_reply_t> reply(
-        xcb_randr_set_crtc_config_reply(XCB::connection(), cookie, nullptr));
-
-    if (!reply) {
-        qCDebug(DISMAN_XRANDR) << "\tResult: unknown (error)";
-        return false;
+    for (auto config : configs) {
+        qCDebug(DISMAN_XRANDR) << "RRSetCrtcConfig"
+                               << "\n"
+                               << "\tCRTC:" << config->crtc << "\n"
+                               << "\tOutputs:" << config->outputs << "\n"
+                               << "\tPos:" << config->position << "\n"
+                               << "\tMode:" << config->mode << "\n"
+                               << "\tRotation:" << config->rotation;
+
+        Cookies request{};
+        if (!config->outputs.isEmpty() && config->setTransform) {
+            // The transform is pending until the CRTC config is set.
+            request.transform = xcb_randr_set_crtc_transform_checked(connection,
+                                                                     config->crtc,
+                                                                     config->transform,
+                                                                     config->filter.size(),
+                                                                     config->filter.constData(),
+                                                                     0,
+                                                                     nullptr);
+        }
+        request.config = xcb_randr_set_crtc_config(connection,
+                                                   config->crtc,
+                                                   XCB_CURRENT_TIME,
+                                                   XCB_CURRENT_TIME,
+                                                   config->position.x(),
+                                                   config->position.y(),
+                                                   config->mode,
+                                                   config->rotation,
+                                                   config->outputs.size(),
+                                                   config->outputs.constData());
+        cookies.push_back(request);
+    }
+
+    std::vector<int> statuses;
+    statuses.reserve(cookies.size());
+
+    for (auto const& request : cookies) {
+        XCB::ScopedPointer<xcb_randr_set_crtc_config_reply_t> reply(
+            static_cast<xcb_randr_set_crtc_config_reply_t*>(
+                XCB::waitForReply(request.config.sequence)));
+        statuses.push_back(reply ? reply->status : -1);
+
+        // The reply to a later request has arrived, so this does not wait.
+        if (request.transform.sequence) {
+            if (auto error = xcb_request_check(connection, request.transform)) {
+                qCDebug(DISMAN_XRANDR) << "Error on logical size transformation!";
+                free(error);
+            }
+        }
     }
-    qCDebug(DISMAN_XRANDR) << "\tResult:" << reply->status;
 
-    // Update the cached output now, otherwise we get RRNotify_CrtcChange notification
-    // for an outdated output, which can lead to a crash.
-    if (reply->status == XCB_RANDR_SET_CONFIG_SUCCESS) {
-        xOutput->update(XCB_NONE,
-                        XCB_NONE,
-                        xOutput->isConnected() ? XCB_RANDR_CONNECTION_CONNECTED
-                                               : XCB_RANDR_CONNECTION_DISCONNECTED,
-                        false);
-    }
-    return (reply->status == XCB_RANDR_SET_CONFIG_SUCCESS);
+    return statuses;
+}
+
 }
 
-bool XRandRConfig::enableOutput(const OutputPtr& dismanOutput, bool primary) const
+bool XRandRConfig::planCrtcConfigs(const Disman::OutputMap& toDisable,
+                                   const Disman::OutputMap& toChange,
+                                   const Disman::OutputMap& toEnable,
+                                   std::vector<CrtcConfig>& configs)
 {
-    XRandRCrtc* freeCrtc = nullptr;
-    qCDebug(DISMAN_XRANDR) << m_crtcs;
-
-    for (auto const& [key, crtc] : m_crtcs) {
-        crtc->update();
-        qCDebug(DISMAN_XRANDR) << "Testing CRTC" << crtc->crtc() << "\n"
-                               << "\tFree:" << crtc->isFree() << "\n"
-                               << "\tMode:" << crtc->mode() << "\n"
-                               << "\tPossible outputs:" << crtc->possibleOutputs() << "\n"
-                               << "\tConnected outputs:" << crtc->outputs() << "\n"
-                               << "\tGeometry:" << crtc->geometry();
-
-        if (crtc->isFree() && crtc->possibleOutputs().contains(dismanOutput->id())) {
-            freeCrtc = crtc;
-            break;
+    // Query all CRTCs at once to know which are free.
+    std::vector<xcb_randr_crtc_t> crtcIds;
+    crtcIds.reserve(m_crtcs.size());
+    for (auto const& [id, crtc] : m_crtcs) {
+        crtcIds.push_back(id);
+    }
+    refreshCrtcs(crtcIds);
+
+    std::set<xcb_randr_crtc_t> freeCrtcs;
+    for (auto const& [id, crtc] : m_crtcs) {
+        if (crtc->isFree()) {
+            freeCrtcs.insert(id);
         }
     }
 
-    if (!freeCrtc) {
-        qCWarning(DISMAN_XRANDR) << "Failed to get free CRTC for output" << dismanOutput->id();
-        return false;
+    for (auto const& [key, dismanOutput] : toDisable) {
+        XRandROutput* xOutput = output(dismanOutput->id());
+        Q_ASSERT(xOutput);
+
+        if (!xOutput->crtc()) {
+            qCWarning(DISMAN_XRANDR) << "Attempting to disable output without CRTC, wth?";
+            continue;
+        }
+
+        CrtcConfig config;
+        config.crtc = xOutput->crtc()->crtc();
+        configs.push_back(config);
+        freeCrtcs.insert(config.crtc);
+    }
+
+    auto enabledConfig = [](const OutputPtr& dismanOutput, xcb_randr_crtc_t crtc) {
+        CrtcConfig config;
+        config.crtc = crtc;
+        config.mode = std::stoi(dismanOutput->auto_mode() ? dismanOutput->auto_mode()->id()
+                                                          : dismanOutput->preferred_mode()->id());
+        config.position = dismanOutput->position().toPoint();
+        config.rotation = static_cast<xcb_randr_rotation_t>(dismanOutput->rotation());
+        config.outputs = {static_cast<xcb_randr_output_t>(dismanOutput->id())};
+        std::tie(config.transform, config.filter)
+            = XRandROutput::logicalSizeTransform(dismanOutput);
+        return config;
+    };
+
+    std::vector<OutputPtr> enables;
+
+    for (auto const& [key, dismanOutput] : toChange) {
+        XRandROutput* xOutput = output(dismanOutput->id());
+        Q_ASSERT(xOutput);
+
+        if (!xOutput->crtc() || toDisable.find(key) != toDisable.end()) {
+            qCDebug(DISMAN_XRANDR) << "Output" << dismanOutput->id()
+                                   << "has no CRTC, enabling it instead";
+            enables.push_back(dismanOutput);
+            continue;
+        }
+        configs.push_back(enabledConfig(dismanOutput, xOutput->crtc()->crtc()));
     }
 
-    XRandROutput* xOutput = output(dismanOutput->id());
-    auto const modeId = std::stoi(dismanOutput->auto_mode() ? dismanOutput->auto_mode()->id()
-                                                            : dismanOutput->preferred_mode()->id());
-    xOutput->updateLogicalSize(dismanOutput, freeCrtc);
+    for (auto const& [key, dismanOutput] : toEnable) {
+        enables.push_back(dismanOutput);
+    }
 
-    qCDebug(DISMAN_XRANDR) << "RRSetCrtcConfig (enable output)"
-                           << "\n"
-                           << "\tOutput:" << dismanOutput->id() << "("
-                           << dismanOutput->name().c_str() << ")"
-                           << "\n"
-                           << "\tNew CRTC:" << freeCrtc->crtc() << "\n"
-                           << "\tPos:" << dismanOutput->position() << "\n"
-                           << "\tMode:" << dismanOutput->auto_mode()
-                           << "Preferred:" << dismanOutput->preferred_mode()->id().c_str() << "\n"
-                           << "\tRotation:" << dismanOutput->rotation();
+    for (auto const& dismanOutput : enables) {
+        auto const outputId = static_cast<xcb_randr_output_t>(dismanOutput->id());
+        auto freeCrtc = std::find_if(freeCrtcs.cbegin(), freeCrtcs.cend(), [&](auto crtcId) {
+            return crtc(crtcId)->possibleOutputs().contains(outputId);
+        });
 
-    if (!sendConfig(dismanOutput, freeCrtc)) {
-        return false;
+        if (freeCrtc == freeCrtcs.cend()) {
+            qCWarning(DISMAN_XRANDR) << "Failed to get free CRTC for output" << outputId;
+            return false;
+        }
+
+        configs.push_back(enabledConfig(dismanOutput, *freeCrtc));
+        freeCrtcs.erase(freeCrtc);
     }
 
-    xOutput->update(freeCrtc->crtc(), modeId, XCB_RANDR_CONNECTION_CONNECTED, primary);
     return true;
 }
 
-bool XRandRConfig::changeOutput(const Disman::OutputPtr& dismanOutput, bool primary) const
+std::vector<XRandRConfig::CrtcResult>
+XRandRConfig::setCrtcConfigs(const std::vector<CrtcConfig>& configs)
 {
-    XRandROutput* xOutput = output(dismanOutput->id());
-    Q_ASSERT(xOutput);
+    std::vector<CrtcResult> results(configs.size());
 
-    if (!xOutput->crtc()) {
-        qCDebug(DISMAN_XRANDR) << "Output" << dismanOutput->id()
-                               << "has no CRTC, falling back to enableOutput()";
-        return enableOutput(dismanOutput, primary);
+    // The current transforms are not cached but needed to roll back.
+    std::vector<XCB::CRTCTransform> transforms(configs.size());
+    for (size_t i = 0; i < configs.size(); ++i) {
+        transforms[i] = XCB::CRTCTransform(configs[i].crtc);
     }
 
-    auto const modeId = std::stoi(dismanOutput->auto_mode() ? dismanOutput->auto_mode()->id()
-                                                            : dismanOutput->preferred_mode()->id());
-    xOutput->updateLogicalSize(dismanOutput);
+    std::vector<const CrtcConfig*> requests;
+    std::vector<xcb_randr_crtc_t> crtcIds;
 
-    qCDebug(DISMAN_XRANDR) << "RRSetCrtcConfig (change output)"
-                           << "\n"
-                           << "\tOutput:" << dismanOutput->id() << "("
-                           << dismanOutput->name().c_str() << ")"
-                           << "\n"
-                           << "\tCRTC:" << xOutput->crtc()->crtc() << "\n"
-                           << "\tPos:" << dismanOutput->position() << "\n"
-                           << "\tMode:" << modeId << dismanOutput->auto_mode() << "\n"
-                           << "\tRotation:" << dismanOutput->rotation();
+    for (size_t i = 0; i < configs.size(); ++i) {
+        auto& result = results[i];
+        result.requested = configs[i];
 
-    if (!sendConfig(dismanOutput, xOutput->crtc())) {
-        return false;
+        auto& previous = result.previous;
+        previous.crtc = configs[i].crtc;
+        if (auto xCrtc = crtc(previous.crtc)) {
+            previous.mode = xCrtc->mode();
+            previous.position = xCrtc->geometry().topLeft();
+            previous.rotation = xCrtc->rotation();
+            previous.outputs = xCrtc->outputs();
+        }
+        if (const auto& transform = transforms[i]) {
+            previous.transform = transform->current_transform;
+            previous.filter
+                = QByteArray(xcb_randr_get_crtc_transform_current_filter_name(transform),
+                             xcb_randr_get_crtc_transform_current_filter_name_length(transform));
+        } else {
+            // Restoring an unknown transform would reset it.
+            previous.setTransform = false;
+        }
+
+        requests.push_back(&result.requested);
+        crtcIds.push_back(previous.crtc);
     }
 
-    xOutput->update(xOutput->crtc()->crtc(), modeId, XCB_RANDR_CONNECTION_CONNECTED, primary);
-    return true;
+    auto statuses = sendCrtcConfigs(requests);
+    for (size_t i = 0; i < results.size(); ++i) {
+        results[i].status = statuses[i];
+        if (!results[i].success()) {
+            qCWarning(DISMAN_XRANDR) << "Failed to set CRTC" << results[i].requested.crtc
+                                     << "with status" << results[i].status;
+        }
+    }
+
+    auto const failed = std::any_of(results.cbegin(), results.cend(), [](auto const& result) {
+        return !result.success();
+    });
+
+    if (failed) {
+        qCWarning(DISMAN_XRANDR) << "Rolling back" << results.size() << "CRTC changes.";
+
+        // Disable changed CRTCs first, so their outputs can be set on their previous CRTCs again.
+        std::vector<CrtcConfig> disabled;
+        disabled.reserve(results.size());
+        std::vector<size_t> indices;
+        requests.clear();
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (results[i].success() && !results[i].requested.outputs.isEmpty()) {
+                CrtcConfig config;
+                config.crtc = results[i].requested.crtc;
+                disabled.push_back(config);
+                requests.push_back(&disabled.back());
+                indices.push_back(i);
+            }
+        }
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (results[i].success() && !results[i].previous.outputs.isEmpty()) {
+                requests.push_back(&results[i].previous);
+                indices.push_back(i);
+            }
+            results[i].rolledBack = results[i].success();
+        }
+
+        statuses = sendCrtcConfigs(requests);
+        for (size_t i = 0; i < statuses.size(); ++i) {
+            if (statuses[i] != XCB_RANDR_SET_CONFIG_SUCCESS) {
+                qCWarning(DISMAN_XRANDR) << "Failed to roll back CRTC" << requests[i]->crtc;
+                results[indices[i]].rolledBack = false;
+            }
+        }
+    }
+
+    // Notifications about these changes are handled only later.
+    refreshCrtcs(crtcIds);
+    return results;
 }
 
-bool XRandRConfig::sendConfig(const Disman::OutputPtr& dismanOutput, XRandRCrtc* crtc) const
+void XRandRConfig::refreshCrtcs(const std::vector<xcb_randr_crtc_t>& crtcs)
 {
-    xcb_randr_output_t outputs[1]{static_cast<xcb_randr_output_t>(dismanOutput->id())};
-    auto const modeId = std::stoi(dismanOutput->auto_mode() ? dismanOutput->auto_mode()->id()
-                                                            : dismanOutput->preferred_mode()->id());
-
-    auto cookie = xcb_randr_set_crtc_config(XCB::connection(),
-                                            crtc->crtc(),
-                                            XCB_CURRENT_TIME,
-                                            XCB_CURRENT_TIME,
-                                            dismanOutput->position().rx(),
-                                            dismanOutput->position().ry(),
-                                            modeId,
-                                            dismanOutput->rotation(),
-                                            1,
-                                            outputs);
-
-    XCB::ScopedPointer<xcb_randr_set_crtc_config_reply_t> reply(
-        xcb_randr_set_crtc_config_reply(XCB::connection(), cookie, nullptr));
-    if (!reply) {
-        qCDebug(DISMAN_XRANDR) << "\tResult: unknown (error)";
-        return false;
+    std::vector<XCB::CRTCInfo> crtcInfos(crtcs.size());
+    for (size_t i = 0; i < crtcs.size(); ++i) {
+        crtcInfos[i] = XCB::CRTCInfo(crtcs[i], XCB_TIME_CURRENT_TIME);
+    }
+    for (size_t i = 0; i < crtcs.size(); ++i) {
+        if (auto xCrtc = crtc(crtcs[i])) {
+            xCrtc->update(crtcInfos[i]);
+        }
+    }
+
+    for (auto const& [id, xOutput] : m_outputs) {
+        XRandRCrtc* outputCrtc = nullptr;
+        for (auto const& [crtcId, xCrtc] : m_crtcs) {
+            if (xCrtc->outputs().contains(id)) {
+                outputCrtc = xCrtc;
+                break;
+            }
+        }
+        xOutput->setCrtc(outputCrtc);
     }
-    qCDebug(DISMAN_XRANDR) << "\tResult: " << reply->status;
-    return (reply->status == XCB_RANDR_SET_CONFIG_SUCCESS);
 }
@@ -17,7 +17,12 @@
  *************************************************************************************/
 #pragma once
 
+#include <QByteArray>
 #include <QObject>
+#include <QPoint>
+#include <QVector>
+
+#include <vector>
 
 #include "xrandr.h"
 #include "xrandrcrtc.h"
@@ -34,6 +39,37 @@ class XRandRConfig : public QObject
     Q_OBJECT
 
 public:
+    /**
+     * A CRTC configuration as set with RRSetCrtcConfig. A CRTC without outputs is disabled.
+     */
+    struct CrtcConfig {
+        xcb_randr_crtc_t crtc{XCB_NONE};
+        xcb_randr_mode_t mode{XCB_NONE};
+        QPoint position;
+        xcb_randr_rotation_t rotation{XCB_RANDR_ROTATION_ROTATE_0};
+        QVector<xcb_randr_output_t> outputs;
+
+        // Only set for CRTCs with outputs.
+        xcb_render_transform_t transform{};
+        QByteArray filter;
+        // False to keep the current transform, for example when it could not be queried.
+        bool setTransform{true};
+    };
+
+    struct CrtcResult {
+        CrtcConfig requested;
+        CrtcConfig previous;
+
+        // One of XCB_RANDR_SET_CONFIG_* or -1 if the request failed with an error.
+        int status{-1};
+        bool rolledBack{false};
+
+        bool success() const
+        {
+            return status == XCB_RANDR_SET_CONFIG_SUCCESS;
+        }
+    };
+
     XRandRConfig();
     ~XRandRConfig() override;
 
@@ -49,8 +85,27 @@ public:
     void addNewCrtc(xcb_randr_crtc_t crtc);
     void removeOutput(xcb_randr_output_t id);
 
+    /**
+     * Marks the primary state of the outputs as outdated. It is queried again on next update.
+     */
+    void invalidatePrimary();
+    void updatePrimary();
+
     Disman::ConfigPtr update_config(Disman::ConfigPtr& config) const;
-    bool applyDismanConfig(const Disman::ConfigPtr& config);
+
+    /**
+     * Sets @p config on the X server. If it can not be set the previous config is kept.
+     *
+     * @param changed set to whether requests changing the X server state were sent
+     * @return false if @p config could not be set
+     */
+    bool applyDismanConfig(const Disman::ConfigPtr& config, bool& changed);
+
+    /**
+     * Sets all CRTCs in @p configs, sending the requests back to back before waiting for the
+     * replies. If setting one of them fails, the others are set back to their previous config.
+     */
+    std::vector<CrtcResult> setCrtcConfigs(const std::vector<CrtcConfig>& configs);
 
 private:
     QSize screenSize(const Disman::ConfigPtr& config) const;
@@ -58,11 +113,19 @@ private:
 
     void setPrimaryOutput(xcb_randr_output_t outputId) const;
 
-    bool disableOutput(const Disman::OutputPtr& output) const;
-    bool enableOutput(const Disman::OutputPtr& output, bool primary) const;
-    bool changeOutput(const Disman::OutputPtr& output, bool primary) const;
+    /**
+     * The CRTC configs to disable, change and enable outputs. Returns false if not all outputs
+     * to enable can get a free CRTC.
+     */
+    bool planCrtcConfigs(const Disman::OutputMap& toDisable,
+                         const Disman::OutputMap& toChange,
+                         const Disman::OutputMap& toEnable,
+                         std::vector<CrtcConfig>& configs);
 
-    bool sendConfig(const Disman::OutputPtr& dismanOutput, XRandRCrtc* crtc) const;
+    /**
+     * Queries the CRTCs again, all at once, and updates which outputs are shown on them.
+     */
+    void refreshCrtcs(const std::vector<xcb_randr_crtc_t>& crtcs);
 
     /**
      * We need to print stuff to discover the damn bug
@@ -74,4 +137,5 @@ private:
     XRandROutput::Map m_outputs;
     XRandRCrtc::Map m_crtcs;
     XRandRScreen* m_screen;
+    bool m_primaryOutdated{false};
 };
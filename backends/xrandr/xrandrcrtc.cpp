@@ -35,6 +35,15 @@ XRandRCrtc::XRandRCrtc(xcb_randr_crtc_t crtc, XRandRConfig* config)
     update();
 }
 
+XRandRCrtc::XRandRCrtc(xcb_randr_crtc_t crtc, const XCB::CRTCInfo& crtcInfo, XRandRConfig* config)
+    : QObject(config)
+    , m_crtc(crtc)
+    , m_mode(0)
+    , m_rotation(XCB_RANDR_ROTATION_ROTATE_0)
+{
+    update(crtcInfo);
+}
+
 xcb_randr_crtc_t XRandRCrtc::crtc() const
 {
     return m_crtc;
@@ -93,6 +102,23 @@ void XRandRCrtc::disconectOutput(xcb_randr_output_t output)
     }
 }
 
+void XRandRCrtc::addOutput(xcb_randr_output_t output)
+{
+    if (!m_possibleOutputs.contains(output)) {
+        // Possible outputs change only with the server configuration. Check it again.
+        connectOutput(output);
+        return;
+    }
+    if (!m_outputs.contains(output)) {
+        m_outputs.append(output);
+    }
+}
+
+void XRandRCrtc::removeOutput(xcb_randr_output_t output)
+{
+    m_outputs.removeOne(output);
+}
+
 bool XRandRCrtc::isFree() const
 {
     return m_outputs.isEmpty();
@@ -100,7 +126,15 @@ bool XRandRCrtc::isFree() const
 
 void XRandRCrtc::update()
 {
-    XCB::CRTCInfo crtcInfo(m_crtc, XCB_TIME_CURRENT_TIME);
+    update(XCB::CRTCInfo(m_crtc, XCB_TIME_CURRENT_TIME));
+}
+
+void XRandRCrtc::update(const XCB::CRTCInfo& crtcInfo)
+{
+    if (!crtcInfo) {
+        return;
+    }
+
     m_mode = crtcInfo->mode;
 
     m_geometry = QRect(crtcInfo->x, crtcInfo->y, crtcInfo->width, crtcInfo->height);
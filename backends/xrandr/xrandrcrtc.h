@@ -24,7 +24,7 @@
 #include <QRect>
 #include <QVector>
 
-#include <xcb/randr.h>
+#include "xcbwrapper.h"
 
 class XRandRConfig;
 
@@ -36,6 +36,7 @@ public:
     using Map = std::map<xcb_randr_crtc_t, XRandRCrtc*>;
 
     XRandRCrtc(xcb_randr_crtc_t crtc, XRandRConfig* config);
+    XRandRCrtc(xcb_randr_crtc_t crtc, const XCB::CRTCInfo& crtcInfo, XRandRConfig* config);
 
     xcb_randr_crtc_t crtc() const;
     xcb_randr_mode_t mode() const;
@@ -49,9 +50,16 @@ public:
     bool connectOutput(xcb_randr_output_t output);
     void disconectOutput(xcb_randr_output_t output);
 
+    /**
+     * Adds or removes @p output as reported by a RandR notification without querying the CRTC.
+     */
+    void addOutput(xcb_randr_output_t output);
+    void removeOutput(xcb_randr_output_t output);
+
     bool isFree() const;
 
     void update();
+    void update(const XCB::CRTCInfo& crtcInfo);
     void update(xcb_randr_crtc_t mode, xcb_randr_rotation_t rotation, const QRect& geom);
 
 private:
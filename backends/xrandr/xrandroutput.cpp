@@ -48,6 +48,17 @@ XRandROutput::XRandROutput(xcb_randr_output_t id, XRandRConfig* config)
     init();
 }
 
+XRandROutput::XRandROutput(xcb_randr_output_t id, const InitData& data, XRandRConfig* config)
+    : QObject(config)
+    , m_config(config)
+    , m_id(id)
+    , m_primary(false)
+    , m_type(Disman::Output::Unknown)
+    , m_crtc(nullptr)
+{
+    init(data);
+}
+
 XRandROutput::~XRandROutput()
 {
 }
@@ -79,7 +90,7 @@ std::string XRandROutput::description() const
 {
     std::string ret;
 
-    Disman::Edid edid(this->edid());
+    const auto& edid = parsedEdid();
     if (edid.isValid()) {
         if (auto vendor = edid.vendor(); vendor.size()) {
             ret += vendor + " ";
@@ -96,7 +107,7 @@ std::string XRandROutput::description() const
 
 std::string XRandROutput::hash() const
 {
-    Disman::Edid edid(this->edid());
+    const auto& edid = parsedEdid();
     if (!edid.isValid()) {
         return m_name.toStdString();
     }
@@ -171,6 +182,20 @@ QByteArray XRandROutput::edid() const
     return m_edid;
 }
 
+void XRandROutput::invalidateEdid()
+{
+    m_edid.clear();
+    m_parsedEdid.reset();
+}
+
+const Disman::Edid& XRandROutput::parsedEdid() const
+{
+    if (!m_parsedEdid) {
+        m_parsedEdid = std::make_unique<Disman::Edid>(edid());
+    }
+    return *m_parsedEdid;
+}
+
 XRandRCrtc* XRandROutput::crtc() const
 {
     return m_crtc;
@@ -213,7 +238,7 @@ void XRandROutput::update(xcb_randr_crtc_t crtc,
             m_modes.clear();
 
             m_preferredModes.clear();
-            m_edid.clear();
+            invalidateEdid();
         }
     } else if (conn == XCB_RANDR_CONNECTION_CONNECTED) {
         // the output changed in some way, let's update the internal
@@ -223,7 +248,7 @@ void XRandROutput::update(xcb_randr_crtc_t crtc,
             updateModes(outputInfo);
         }
 
-        m_hotplugModeUpdate = XRandR::hasProperty(m_id, "hotplug_mode_update");
+        m_hotplugModeUpdate = XRandR::hasProperty(m_id, XCB::atoms().hotplugModeUpdate);
     }
 
     // A monitor has been enabled or disabled
@@ -246,6 +271,35 @@ void XRandROutput::update(xcb_randr_crtc_t crtc,
     m_primary = primary;
 }
 
+void XRandROutput::updateFromNotify(xcb_randr_crtc_t crtc,
+                                    xcb_randr_mode_t mode,
+                                    xcb_randr_connection_t conn,
+                                    xcb_timestamp_t configTimestamp)
+{
+    if (isConnected() != (conn == XCB_RANDR_CONNECTION_CONNECTED)
+        || configTimestamp != m_configTimestamp) {
+        qCDebug(DISMAN_XRANDR) << "XRandROutput" << m_id << "outdated, querying it again.";
+        update(crtc, mode, conn, m_primary);
+        return;
+    }
+
+    setCrtc(crtc == XCB_NONE ? nullptr : m_config->crtc(crtc));
+}
+
+void XRandROutput::setCrtc(XRandRCrtc* crtc)
+{
+    if (m_crtc == crtc) {
+        return;
+    }
+    if (m_crtc) {
+        m_crtc->removeOutput(m_id);
+    }
+    m_crtc = crtc;
+    if (m_crtc) {
+        m_crtc->addOutput(m_id);
+    }
+}
+
 void XRandROutput::setIsPrimary(bool primary)
 {
     m_primary = primary;
@@ -254,42 +308,70 @@ void XRandROutput::setIsPrimary(bool primary)
 void XRandROutput::init()
 {
     XCB::OutputInfo outputInfo(m_id, XCB_TIME_CURRENT_TIME);
+    XCB::PrimaryOutput primary(XRandR::rootWindow());
+
     Q_ASSERT(outputInfo);
     if (!outputInfo) {
         return;
     }
 
-    XCB::PrimaryOutput primary(XRandR::rootWindow());
+    XCB::ScopedPointer<xcb_randr_get_screen_resources_reply_t> screenResources(
+        XRandR::screenResources());
+
+    init({outputInfo,
+          screenResources.data(),
+          primary ? primary->output : static_cast<xcb_randr_output_t>(XCB_NONE),
+          typeFromProperty(m_id),
+          XRandR::hasProperty(m_id, XCB::atoms().hotplugModeUpdate),
+          QByteArray()});
+}
+
+void XRandROutput::init(const InitData& data)
+{
+    const auto& outputInfo = data.info;
+    Q_ASSERT(outputInfo);
+    if (!outputInfo) {
+        return;
+    }
 
     m_name = QString::fromUtf8((const char*)xcb_randr_get_output_info_name(outputInfo.data()),
                                outputInfo->name_len);
-    m_type = fetchOutputType(m_id, m_name);
+    m_type = outputType(data.type, m_name);
     m_connected = (xcb_randr_connection_t)outputInfo->connection;
-    m_primary = (primary->output == m_id);
+    m_primary = (data.primary == m_id);
 
     m_widthMm = outputInfo->mm_width;
     m_heightMm = outputInfo->mm_height;
 
     m_crtc = m_config->crtc(outputInfo->crtc);
-    if (m_crtc) {
+    if (m_crtc && !m_crtc->outputs().contains(m_id)) {
+        // Only then the CRTC info is outdated and must be fetched again.
         m_crtc->connectOutput(m_id);
     }
-    m_hotplugModeUpdate = XRandR::hasProperty(m_id, "hotplug_mode_update");
+    m_hotplugModeUpdate = data.hotplugModeUpdate;
+    m_edid = data.edid;
+    m_parsedEdid.reset();
 
-    updateModes(outputInfo);
+    updateModes(outputInfo, data.resources);
 }
 
 void XRandROutput::updateModes(const XCB::OutputInfo& outputInfo)
 {
-    /* Init modes */
     XCB::ScopedPointer<xcb_randr_get_screen_resources_reply_t> screenResources(
         XRandR::screenResources());
+    updateModes(outputInfo, screenResources.data());
+}
 
+void XRandROutput::updateModes(const XCB::OutputInfo& outputInfo,
+                               const xcb_randr_get_screen_resources_reply_t* screenResources)
+{
+    /* Init modes */
     Q_ASSERT(screenResources);
     if (!screenResources) {
         return;
     }
-    xcb_randr_mode_info_t* modes = xcb_randr_get_screen_resources_modes(screenResources.data());
+    m_configTimestamp = screenResources->config_timestamp;
+    xcb_randr_mode_info_t* modes = xcb_randr_get_screen_resources_modes(screenResources);
     xcb_randr_mode_t* outputModes = xcb_randr_get_output_info_modes(outputInfo.data());
 
     m_preferredModes.clear();
@@ -323,9 +405,9 @@ void XRandROutput::updateModes(const XCB::OutputInfo& outputInfo)
     }
 }
 
-Disman::Output::Type XRandROutput::fetchOutputType(xcb_randr_output_t outputId, const QString& name)
+Disman::Output::Type XRandROutput::outputType(const QByteArray& typeProperty, const QString& name)
 {
-    QString type = QString::fromUtf8(typeFromProperty(outputId));
+    QString type = QString::fromUtf8(typeProperty);
     if (type.isEmpty()) {
         type = name;
     }
@@ -335,38 +417,41 @@ Disman::Output::Type XRandROutput::fetchOutputType(xcb_randr_output_t outputId,
 
 QByteArray XRandROutput::typeFromProperty(xcb_randr_output_t outputId)
 {
-    QByteArray type;
+    const auto typeAtomId = XCB::atoms().connectorType;
+    if (typeAtomId == XCB_ATOM_NONE) {
+        return QByteArray();
+    }
 
-    XCB::InternAtom atomType(true, 13, "ConnectorType");
-    if (!atomType) {
-        return type;
+    XCB::OutputProperty reply(outputId, typeAtomId, XCB_ATOM_ANY, 0, 100, false, false);
+
+    const auto atom = typeAtom(reply);
+    if (atom == XCB_ATOM_NONE) {
+        return QByteArray();
     }
 
-    auto cookie = xcb_randr_get_output_property(
-        XCB::connection(), outputId, atomType->atom, XCB_ATOM_ANY, 0, 100, false, false);
-    XCB::ScopedPointer<xcb_randr_get_output_property_reply_t> reply(
-        xcb_randr_get_output_property_reply(XCB::connection(), cookie, nullptr));
+    XCB::AtomName atomName(atom);
+    return typeName(atomName);
+}
+
+xcb_atom_t XRandROutput::typeAtom(const xcb_randr_get_output_property_reply_t* reply)
+{
     if (!reply) {
-        return type;
+        return XCB_ATOM_NONE;
     }
-
     if (!(reply->type == XCB_ATOM_ATOM && reply->format == 32 && reply->num_items == 1)) {
-        return type;
+        return XCB_ATOM_NONE;
     }
 
-    const uint8_t* prop = xcb_randr_get_output_property_data(reply.data());
-    XCB::AtomName atomName(*reinterpret_cast<const xcb_atom_t*>(prop));
-    if (!atomName) {
-        return type;
-    }
+    const uint8_t* prop = xcb_randr_get_output_property_data(reply);
+    return *reinterpret_cast<const xcb_atom_t*>(prop);
+}
 
-    char* connectorType = xcb_get_atom_name_name(atomName);
-    if (!connectorType) {
-        return type;
+QByteArray XRandROutput::typeName(const xcb_get_atom_name_reply_t* reply)
+{
+    if (!reply) {
+        return QByteArray();
     }
-
-    type = connectorType;
-    return type;
+    return QByteArray(xcb_get_atom_name_name(reply), xcb_get_atom_name_name_length(reply));
 }
 
 bool isScaling(const xcb_render_transform_t& tr)
@@ -430,14 +515,9 @@ QSizeF XRandROutput::logicalSize() const
     return QSizeF(width, height);
 }
 
-void XRandROutput::updateLogicalSize(const Disman::OutputPtr& output, XRandRCrtc* crtc)
+std::pair<xcb_render_transform_t, QByteArray>
+XRandROutput::logicalSizeTransform(const Disman::OutputPtr& output)
 {
-    if (!crtc) {
-        // TODO: This is a workaround for now when updateLogicalSize is called on enabling the
-        //       output. At this point m_crtc is not yet set. Change the order in the future so
-        //       that the additional argument is not necessary anymore.
-        crtc = m_crtc;
-    }
     auto const logicalSize = output->geometry().size();
     xcb_render_transform_t transform = unityTransform();
 
@@ -454,20 +534,7 @@ void XRandROutput::updateLogicalSize(const Disman::OutputPtr& output, XRandRCrtc
         transform.matrix22 = DOUBLE_TO_FIXED(heightFactor);
     }
 
-    QByteArray filterName(isScaling(transform) ? "bilinear" : "nearest");
-
-    auto cookie = xcb_randr_set_crtc_transform_checked(XCB::connection(),
-                                                       crtc->crtc(),
-                                                       transform,
-                                                       filterName.size(),
-                                                       filterName.data(),
-                                                       0,
-                                                       nullptr);
-    xcb_generic_error_t* error = xcb_request_check(XCB::connection(), cookie);
-    if (error) {
-        qCDebug(DISMAN_XRANDR) << "Error on logical size transformation!";
-        free(error);
-    }
+    return {transform, QByteArray(isScaling(transform) ? "bilinear" : "nearest")};
 }
 
 void XRandROutput::updateDismanOutput(Disman::OutputPtr& dismanOutput) const
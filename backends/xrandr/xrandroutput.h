@@ -24,11 +24,15 @@
 
 #include <QObject>
 
+#include <memory>
+#include <utility>
+
 class XRandRConfig;
 class XRandRCrtc;
 namespace Disman
 {
 class Config;
+class Edid;
 class Output;
 }
 
@@ -39,7 +43,21 @@ class XRandROutput : public QObject
 public:
     using Map = std::map<xcb_randr_output_t, XRandROutput*>;
 
+    /**
+     * Replies an output is initialized from. These can be requested for all outputs at once.
+     */
+    struct InitData {
+        const XCB::OutputInfo& info;
+        const xcb_randr_get_screen_resources_reply_t* resources;
+        xcb_randr_output_t primary;
+        QByteArray type;
+        bool hotplugModeUpdate;
+        // A null array if the EDID was not requested yet.
+        QByteArray edid;
+    };
+
     explicit XRandROutput(xcb_randr_output_t id, XRandRConfig* config);
+    XRandROutput(xcb_randr_output_t id, const InitData& data, XRandRConfig* config);
     ~XRandROutput() override;
 
     void disconnected();
@@ -48,6 +66,16 @@ public:
     void
     update(xcb_randr_crtc_t crtc, xcb_randr_mode_t mode, xcb_randr_connection_t conn, bool primary);
 
+    /**
+     * Updates the output from the state in a RandR output change notification. The output is
+     * only queried again if its connection changed or the server configuration changed since it
+     * was queried last, as indicated by @p configTimestamp.
+     */
+    void updateFromNotify(xcb_randr_crtc_t crtc,
+                          xcb_randr_mode_t mode,
+                          xcb_randr_connection_t conn,
+                          xcb_timestamp_t configTimestamp);
+
     void setIsPrimary(bool primary);
 
     xcb_randr_output_t id() const;
@@ -68,19 +96,43 @@ public:
     bool isHorizontal() const;
 
     QByteArray edid() const;
+    /**
+     * Drops the EDID so it is fetched and parsed again on next use.
+     */
+    void invalidateEdid();
     XRandRCrtc* crtc() const;
 
     void updateDismanOutput(Disman::OutputPtr& dismanOutput) const;
 
-    void updateLogicalSize(const Disman::OutputPtr& output, XRandRCrtc* crtc = nullptr);
+    /**
+     * Sets the CRTC the output is shown on without querying either of them.
+     */
+    void setCrtc(XRandRCrtc* crtc);
+
+    /**
+     * The CRTC transform and its filter to scale the mode of @p output to its logical size.
+     */
+    static std::pair<xcb_render_transform_t, QByteArray>
+    logicalSizeTransform(const Disman::OutputPtr& output);
+
+    /**
+     * The atom naming the connector type in a reply to a ConnectorType property request or
+     * XCB_ATOM_NONE if the reply has no valid connector type.
+     */
+    static xcb_atom_t typeAtom(const xcb_randr_get_output_property_reply_t* reply);
+    static QByteArray typeName(const xcb_get_atom_name_reply_t* reply);
 
 private:
     void init();
+    void init(const InitData& data);
     void updateModes(const XCB::OutputInfo& outputInfo);
+    void updateModes(const XCB::OutputInfo& outputInfo,
+                     const xcb_randr_get_screen_resources_reply_t* resources);
+    const Disman::Edid& parsedEdid() const;
     std::string description() const;
     std::string hash() const;
 
-    static Disman::Output::Type fetchOutputType(xcb_randr_output_t outputId, const QString& name);
+    static Disman::Output::Type outputType(const QByteArray& typeProperty, const QString& name);
     static QByteArray typeFromProperty(xcb_randr_output_t outputId);
 
     xcb_render_transform_t currentTransform() const;
@@ -89,6 +141,7 @@ private:
     xcb_randr_output_t m_id;
     QString m_name;
     mutable QByteArray m_edid;
+    mutable std::unique_ptr<Disman::Edid> m_parsedEdid;
 
     xcb_randr_connection_t m_connected;
     bool m_primary;
@@ -102,6 +155,9 @@ private:
 
     bool m_hotplugModeUpdate = false;
     XRandRCrtc* m_crtc;
+
+    // Of the server configuration the modes were queried at.
+    xcb_timestamp_t m_configTimestamp{XCB_CURRENT_TIME};
 };
 
 Q_DECLARE_METATYPE(XRandROutput::Map)
@@ -25,10 +25,9 @@
 
 #include <QtGui/private/qtx11extras_p.h>
 
-XRandRScreen::XRandRScreen(XRandRConfig* config)
+XRandRScreen::XRandRScreen(const XCB::ScreenSize& size, XRandRConfig* config)
     : QObject(config)
 {
-    XCB::ScreenSize size(XRandR::rootWindow());
     m_maxSize = QSize(size->max_width, size->max_height);
     m_minSize = QSize(size->min_width, size->min_height);
     update();
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "types.h"
+#include "xcbwrapper.h"
 
 #include <QObject>
 #include <QSize>
@@ -34,7 +35,7 @@ class XRandRScreen : public QObject
     Q_OBJECT
 
 public:
-    explicit XRandRScreen(XRandRConfig* config = nullptr);
+    explicit XRandRScreen(const XCB::ScreenSize& size, XRandRConfig* config = nullptr);
     ~XRandRScreen() override;
 
     Disman::ScreenPtr toDismanScreen() const;
@@ -8,10 +8,15 @@
 #include "watcher.h"
 
 #include <QCommandLineParser>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QRectF>
 
+#include "backend.h"
 #include "backendmanager_p.h"
 #include "config.h"
 #include "configoperation.h"
@@ -53,8 +58,18 @@ Doctor::Doctor(QCommandLineParser* parser, QObject* parent)
     if (m_parser->isSet(QStringLiteral("info"))) {
         showBackends();
     }
-    if (parser->isSet(QStringLiteral("json")) || parser->isSet(QStringLiteral("outputs"))
-        || parser->isSet(QStringLiteral("watch")) || !m_parser->positionalArguments().isEmpty()) {
+    if (m_parser->isSet(QStringLiteral("gc"))) {
+        // Continues with the other options once the backend collected the control files.
+        collectGarbage();
+        return;
+    }
+    processOptions();
+}
+
+void Doctor::processOptions()
+{
+    if (m_parser->isSet(QStringLiteral("json")) || m_parser->isSet(QStringLiteral("outputs"))
+        || m_parser->isSet(QStringLiteral("watch")) || !m_parser->positionalArguments().isEmpty()) {
 
         Disman::GetConfigOperation* op = new Disman::GetConfigOperation();
         connect(op,
@@ -113,6 +128,101 @@ void Doctor::showBackends() const
     cout << Qt::endl;
 }
 
+void Doctor::collectGarbage()
+{
+    int max_count = -1;
+    int max_age = -1;
+
+    auto read_limit = [this](QString const& name, int& limit) {
+        if (!m_parser->isSet(name)) {
+            return true;
+        }
+        bool ok;
+        auto const value = m_parser->value(name).toInt(&ok);
+        if (!ok || value < 0) {
+            cerr << "Unable to parse " << name << ": " << m_parser->value(name) << Qt::endl;
+            return false;
+        }
+        limit = value;
+        return true;
+    };
+    if (!read_limit(QStringLiteral("max-count"), max_count)
+        || !read_limit(QStringLiteral("max-age"), max_age)) {
+        // The event loop is not running yet, so the exit code must be set from within it.
+        QTimer::singleShot(0, qApp, [] { qApp->exit(2); });
+        return;
+    }
+
+    auto manager = BackendManager::instance();
+
+    if (manager->method() == BackendManager::InProcess) {
+        auto const name = QString::fromUtf8(qgetenv("DISMAN_BACKEND"));
+        auto backend = manager->load_backend_in_process(name);
+        if (!backend) {
+            cerr << "Unable to load the backend." << Qt::endl;
+            QTimer::singleShot(0, qApp, [] { qApp->exit(2); });
+            return;
+        }
+        showGarbageCollection(backend->collect_garbage(max_count, max_age));
+        processOptions();
+        return;
+    }
+
+    // The backend collects the files itself, so they are not removed behind its pending writes.
+    connect(
+        manager,
+        &BackendManager::backend_ready,
+        this,
+        [this, max_count, max_age](OrgKwinftDismanBackendInterface* backend) {
+            if (!backend) {
+                cerr << "Unable to reach the backend." << Qt::endl;
+                qApp->exit(2);
+                return;
+            }
+
+            auto call = QDBusMessage::createMethodCall(QStringLiteral("org.kwinft.disman"),
+                                                       QStringLiteral("/backend"),
+                                                       QStringLiteral("org.kwinft.disman.backend"),
+                                                       QStringLiteral("collectGarbage"));
+            call.setArguments({max_count, max_age});
+
+            auto watcher
+                = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(call), this);
+            connect(watcher,
+                    &QDBusPendingCallWatcher::finished,
+                    this,
+                    &Doctor::garbageCollected);
+        },
+        Qt::SingleShotConnection);
+    manager->request_backend();
+}
+
+void Doctor::garbageCollected(QDBusPendingCallWatcher* watcher)
+{
+    watcher->deleteLater();
+
+    QDBusPendingReply<QVariantMap> const reply = *watcher;
+    if (reply.isError()) {
+        cerr << "Collecting control files failed: " << reply.error().message() << Qt::endl;
+        qApp->exit(2);
+        return;
+    }
+
+    showGarbageCollection(reply.value());
+    processOptions();
+}
+
+void Doctor::showGarbageCollection(QVariantMap const& result)
+{
+    auto const removed = result[QStringLiteral("removed")].toStringList();
+    for (auto const& path : removed) {
+        cout << "Removed: " << path << Qt::endl;
+    }
+    cout << "Reclaimed " << bold << removed.size() << cr << " control files ("
+         << result[QStringLiteral("reclaimed-bytes")].toLongLong() << " bytes), kept "
+         << result[QStringLiteral("kept")].toInt() << "." << Qt::endl;
+}
+
 void Doctor::parsePositionalArgs()
 {
     auto const& args = m_parser->positionalArguments();
@@ -122,7 +232,7 @@ void Doctor::parsePositionalArgs()
             bool ok;
             int output_id = -1;
             if (ops[0] == QLatin1String("output")) {
-                for (auto const& [key, output] : m_config->outputs()) {
+                for (auto const& [key, output] : m_config->output_map()) {
                     if (output->name() == ops[1].toStdString()) {
                         output_id = output->id();
                     }
@@ -278,7 +388,7 @@ void Doctor::showOutputs(const Disman::ConfigPtr& config)
     typeString[Disman::Output::TVC4] = QStringLiteral("TVC4");
     typeString[Disman::Output::DisplayPort] = QStringLiteral("DisplayPort");
 
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         cout << green << "Output: " << cr << output->id() << " " << output->name().c_str();
         cout << " "
              << (output->enabled() ? green + QLatin1String("enabled")
@@ -325,7 +435,7 @@ bool Doctor::setEnabled(int id, bool enabled = true)
         return false;
     }
 
-    for (auto& [key, output] : m_config->outputs()) {
+    for (auto const& [key, output] : m_config->output_map()) {
         if (output->id() == id) {
             cout << (enabled ? "Enabling " : "Disabling ") << "output " << id << Qt::endl;
             output->set_enabled(enabled);
@@ -345,7 +455,7 @@ bool Doctor::setPosition(int id, const QPoint& pos)
         return false;
     }
 
-    for (auto& [key, output] : m_config->outputs()) {
+    for (auto const& [key, output] : m_config->output_map()) {
         if (output->id() == id) {
             qCDebug(DISMAN_CTL) << "Set output position" << pos;
             output->set_position(pos);
@@ -364,7 +474,7 @@ bool Doctor::setMode(int id, std::string const& mode_id)
         return false;
     }
 
-    for (auto& [key, output] : m_config->outputs()) {
+    for (auto const& [key, output] : m_config->output_map()) {
         if (output->id() == id) {
             // find mode
             for (auto const& [key, mode] : output->modes()) {
@@ -392,7 +502,7 @@ bool Doctor::setScale(int id, qreal scale)
         return false;
     }
 
-    for (auto& [key, output] : m_config->outputs()) {
+    for (auto const& [key, output] : m_config->output_map()) {
         if (output->id() == id) {
             output->set_scale(scale);
             m_changed = true;
@@ -410,7 +520,7 @@ bool Doctor::setRotation(int id, Disman::Output::Rotation rot)
         return false;
     }
 
-    for (auto& [key, output] : m_config->outputs()) {
+    for (auto const& [key, output] : m_config->output_map()) {
         if (output->id() == id) {
             output->set_rotation(rot);
             m_changed = true;
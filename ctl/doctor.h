@@ -15,6 +15,7 @@
 #include <memory>
 
 class QCommandLineParser;
+class QDBusPendingCallWatcher;
 
 namespace Disman
 {
@@ -35,6 +36,8 @@ public:
     void showBackends() const;
     static void showOutputs(Disman::ConfigPtr const& config);
     void showJson() const;
+    void collectGarbage();
+    static void showGarbageCollection(QVariantMap const& result);
 
     bool setEnabled(int id, bool enabled);
     bool setPosition(int id, const QPoint& pos);
@@ -43,6 +46,8 @@ public:
     bool setRotation(int id, Disman::Output::Rotation rot);
 
 private:
+    void processOptions();
+    void garbageCollected(QDBusPendingCallWatcher* watcher);
     void applyConfig();
     void parsePositionalArgs();
     int parseInt(const QString& str, bool& ok) const;
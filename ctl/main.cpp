@@ -50,7 +50,9 @@ int main(int argc, char** argv)
         "\n   Set scale (note: fractional scaling is only supported on wayland)\n"
         "   $ dismanctl output.HDMI-2.scale.2 \n"
         "\n   Set rotation (possible values: none, left, right, inverted)\n"
-        "   $ dismanctl output.HDMI-2.rotation.left \n");
+        "   $ dismanctl output.HDMI-2.rotation.left \n"
+        "\n   Remove control files of outputs not seen for 90 days\n"
+        "   $ dismanctl --gc --max-age 90 \n");
     /*
         "\nError codes:\n"
         "   2 : general parse error\n"
@@ -90,6 +92,21 @@ int main(int argc, char** argv)
         = QCommandLineOption(QStringList() << QStringLiteral("w") << QStringLiteral("watch"),
                              QStringLiteral("Watch for changes and print them to stdout."));
 
+    QCommandLineOption gc = QCommandLineOption(
+        QStringList() << QStringLiteral("gc"),
+        QStringLiteral("Remove control files not used for a long time and report what was "
+                       "reclaimed."));
+    QCommandLineOption max_count
+        = QCommandLineOption(QStringList() << QStringLiteral("max-count"),
+                             QStringLiteral("With --gc keep at most this many control files of "
+                                            "each kind. Zero for no limit."),
+                             QStringLiteral("count"));
+    QCommandLineOption max_age
+        = QCommandLineOption(QStringList() << QStringLiteral("max-age"),
+                             QStringLiteral("With --gc remove control files not used for this "
+                                            "many days. Zero for no limit."),
+                             QStringLiteral("days"));
+
     QCommandLineParser parser;
     parser.setApplicationDescription(desc);
     parser.addPositionalArgument(
@@ -102,6 +119,9 @@ int main(int argc, char** argv)
     parser.addOption(outputs);
     parser.addOption(log);
     parser.addOption(watch);
+    parser.addOption(gc);
+    parser.addOption(max_count);
+    parser.addOption(max_age);
     parser.process(app);
 
     Disman::Ctl::Doctor server(&parser);
@@ -14,4 +14,9 @@ Backend::Backend(QObject* parent)
 {
 }
 
+QVariantMap Backend::collect_garbage([[maybe_unused]] int max_count, [[maybe_unused]] int max_age)
+{
+    return QVariantMap();
+}
+
 }
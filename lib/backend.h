@@ -72,6 +72,17 @@ public:
      */
     virtual bool valid() const = 0;
 
+    /**
+     * Removes control files that were not used for a long time. Backends writing control files
+     * run this behind their pending writes, so no other process touches the files meanwhile.
+     *
+     * @param max_count maximal number of files per directory, negative for the default
+     * @param max_age maximal number of days since the last use, negative for the default
+     * @return the paths of the removed files as "removed", the freed bytes as "reclaimed-bytes"
+     *         and the number of kept files as "kept", empty if the backend has no control files
+     */
+    virtual QVariantMap collect_garbage(int max_count, int max_age);
+
 Q_SIGNALS:
     /**
      * Emitted when backend detects a change in configuration
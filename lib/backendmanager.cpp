@@ -24,15 +24,19 @@
 #include "config.h"
 #include "configmonitor.h"
 #include "configserializer_p.h"
+#include "configsnapshot_p.h"
 #include "disman_debug.h"
 #include "getconfigoperation.h"
 #include "log.h"
+#include "mode.h"
+#include "output.h"
 
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
 #include <QDBusPendingCall>
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
+#include <QDBusUnixFileDescriptor>
 #include <QGuiApplication>
 #include <QStandardPaths>
 #include <QThread>
@@ -59,6 +63,7 @@ BackendManager* BackendManager::instance()
 BackendManager::BackendManager()
     : mInterface(nullptr)
     , mCrashCount(0)
+    , mSharedConfig{std::make_unique<ConfigSnapshotReader>()}
     , mShuttingDown(false)
     , mRequestsCounter(0)
     , mLoader(nullptr)
@@ -90,6 +95,7 @@ void BackendManager::init_method()
 {
     if (mMethod == OutOfProcess) {
         qRegisterMetaType<org::kwinft::disman::backend*>("OrgKwinftDismanBackendInterface");
+        ConfigSerializer::register_dbus_types();
 
         mServiceWatcher.setConnection(QDBusConnection::sessionBus());
         connect(&mServiceWatcher,
@@ -394,17 +400,263 @@ void BackendManager::on_backend_request_done(QDBusPendingCallWatcher* watcher)
     mServiceWatcher.addWatchedService(mBackendService);
 
     // Immediatelly request config
-    connect(new GetConfigOperation, &GetConfigOperation::finished, this, [&](ConfigOperation* op) {
-        mConfig = qobject_cast<GetConfigOperation*>(op)->config();
+    invalidate_cached_config();
+    // The operation updates the cached config itself.
+    refresh_config();
+    connect(mRefreshOperation, &GetConfigOperation::finished, this, [this] {
         emit_backend_ready();
     });
-    // And listen for its change.
-    connect(mInterface,
-            &org::kwinft::disman::backend::configChanged,
+    // And listen for its change. If the launcher publishes its config in shared memory, changes
+    // are read from there, otherwise they are received compact.
+    request_shared_config();
+}
+
+void BackendManager::request_config_deltas()
+{
+    if (mConfigDeltas) {
+        return;
+    }
+    mConfigDeltas = true;
+    if (mInterface && !mSharedConfigWatcher) {
+        subscribe_config_changes();
+    }
+}
+
+void BackendManager::backend_config_changed(ConfigSerializer::DBusConfig const& config)
+{
+    invalidate_cached_config();
+    update_cached_config(config.config, config_stamp());
+}
+
+void BackendManager::refresh_config()
+{
+    if (mRefreshOperation) {
+        // The running operation might have read the config before the change.
+        mRefreshPending = true;
+        return;
+    }
+
+    mRefreshPending = false;
+    mRefreshOperation = new GetConfigOperation(GetConfigOperation::Option::NoCache);
+    connect(mRefreshOperation,
+            &GetConfigOperation::finished,
+            this,
+            &BackendManager::config_refreshed);
+}
+
+void BackendManager::config_refreshed(ConfigOperation* operation)
+{
+    if (operation != mRefreshOperation) {
+        return;
+    }
+    mRefreshOperation.clear();
+
+    if (operation->has_error()) {
+        qCWarning(DISMAN) << "Failed to refresh the backend config:" << operation->error_string();
+    }
+    if (mRefreshPending && mInterface) {
+        refresh_config();
+    }
+}
+
+void BackendManager::subscribe_config_changes()
+{
+    uint32_t channels = 0;
+    if (mConfigDeltas) {
+        channels |= ConfigSerializer::delta_channel;
+    }
+
+    if (mSharedConfig->mapped()) {
+        // Nobody needs the mode lists anymore.
+        disconnect(mInterface,
+                   &org::kwinft::disman::backend::configChangedCompact,
+                   this,
+                   &BackendManager::backend_compact_config_changed);
+        mModeTables.clear();
+    } else {
+        channels |= ConfigSerializer::compact_channel;
+        // Connect first. The launcher might send the signal right after its reply.
+        connect(mInterface,
+                &org::kwinft::disman::backend::configChangedCompact,
+                this,
+                &BackendManager::backend_compact_config_changed,
+                Qt::UniqueConnection);
+    }
+
+    auto watcher = new QDBusPendingCallWatcher(
+        mInterface->subscribeConfigChanges(ConfigSerializer::compact_config_version, channels),
+        mInterface);
+    connect(watcher,
+            &QDBusPendingCallWatcher::finished,
+            this,
+            &BackendManager::config_changes_subscribed);
+}
+
+void BackendManager::config_changes_subscribed(QDBusPendingCallWatcher* watcher)
+{
+    watcher->deleteLater();
+
+    QDBusPendingReply<bool> reply = *watcher;
+    if (!reply.isError() && reply.value()) {
+        return;
+    }
+
+    // Older launchers only send full configs to everyone.
+    qCDebug(DISMAN) << "Config change channels not supported by the launcher.";
+    disconnect(mInterface,
+               &org::kwinft::disman::backend::configChangedCompact,
+               this,
+               &BackendManager::backend_compact_config_changed);
+    if (!mSharedConfig->mapped()) {
+        connect(mInterface,
+                &org::kwinft::disman::backend::configChanged,
+                this,
+                &BackendManager::backend_config_changed,
+                Qt::UniqueConnection);
+    }
+}
+
+void BackendManager::backend_compact_config_changed(
+    ConfigSerializer::DBusCompactConfig const& config)
+{
+    if (!restore_omitted_modes(config.config, config.omitted_mode_tables)) {
+        // Some mode list is not known. Subscribing again makes the launcher send all of them
+        // next time. Get the full config meanwhile, the operation updates the cached config.
+        subscribe_config_changes();
+        invalidate_cached_config();
+        refresh_config();
+        return;
+    }
+
+    // The launcher omits the mode lists of this config in the next one it sends here.
+    set_mode_tables(config.config);
+
+    invalidate_cached_config();
+    update_cached_config(config.config, config_stamp());
+}
+
+void BackendManager::request_shared_config()
+{
+    if (!mInterface || mSharedConfigWatcher) {
+        return;
+    }
+
+    mSharedConfigWatcher
+        = new QDBusPendingCallWatcher(mInterface->getConfigSharedMemory(), mInterface);
+    connect(mSharedConfigWatcher,
+            &QDBusPendingCallWatcher::finished,
             this,
-            [&](const QVariantMap& newConfig) {
-                mConfig = Disman::ConfigSerializer::deserialize_config(newConfig);
-            });
+            &BackendManager::shared_config_received);
+}
+
+void BackendManager::shared_config_received(QDBusPendingCallWatcher* watcher)
+{
+    watcher->deleteLater();
+
+    QDBusPendingReply<QDBusUnixFileDescriptor> reply = *watcher;
+    if (reply.isError()) {
+        qCDebug(DISMAN) << "Config not available in shared memory:" << reply.error().message();
+    } else if (mSharedConfig->map(reply.value().fileDescriptor())) {
+        // From now on full configs are read from the shared region on wake-up. This way they
+        // are not sent to every client on every change anymore.
+        disconnect(mInterface,
+                   &org::kwinft::disman::backend::configChanged,
+                   this,
+                   &BackendManager::backend_config_changed);
+        connect(mInterface,
+                &org::kwinft::disman::backend::configPublished,
+                this,
+                &BackendManager::shared_config_published,
+                Qt::UniqueConnection);
+    }
+
+    // Only subscribe now, so compact changes are not sent when the shared region is mapped.
+    subscribe_config_changes();
+
+    if (mSharedConfig->mapped()) {
+        // A change might have been published meanwhile.
+        shared_config_published(0);
+    }
+}
+
+void BackendManager::shared_config_published(qulonglong generation)
+{
+    invalidate_cached_config();
+
+    if (mSharedConfig->retired()) {
+        // The launcher replaced the region or stopped publishing. Until we know which one no
+        // changes are received.
+        mSharedConfig->unmap();
+        disconnect(mInterface,
+                   &org::kwinft::disman::backend::configPublished,
+                   this,
+                   &BackendManager::shared_config_published);
+        request_shared_config();
+        return;
+    }
+
+    uint64_t read_generation;
+    auto config = mSharedConfig->read(read_generation);
+    if (!config || read_generation < generation) {
+        refresh_config();
+        return;
+    }
+
+    // The config is only cached if no newer one was published or is pending meanwhile.
+    update_cached_config(config, {mConfigGeneration, read_generation, true});
+}
+
+ConfigPtr BackendManager::shared_config(uint64_t& generation) const
+{
+    if (!mSharedConfig->mapped() || mSharedConfig->retired()) {
+        return ConfigPtr();
+    }
+    return mSharedConfig->read(generation);
+}
+
+void BackendManager::set_mode_tables(ConfigPtr const& config)
+{
+    if (!config) {
+        return;
+    }
+
+    std::map<uint64_t, ModeMap> tables;
+    for (auto const& [id, output] : config->output_map()) {
+        if (tables.find(output->modes_fingerprint()) != tables.end()) {
+            continue;
+        }
+
+        ModeMap modes;
+        for (auto const& [key, mode] : output->mode_map()) {
+            modes.insert({key, mode->clone()});
+        }
+        tables.insert({output->modes_fingerprint(), modes});
+    }
+    mModeTables = std::move(tables);
+}
+
+bool BackendManager::restore_omitted_modes(ConfigPtr const& config,
+                                           std::map<int, uint64_t> const& omitted_mode_tables) const
+{
+    if (!config) {
+        return omitted_mode_tables.empty();
+    }
+
+    for (auto const& [id, fingerprint] : omitted_mode_tables) {
+        auto const table = mModeTables.find(fingerprint);
+        auto output = config->output(id);
+        if (table == mModeTables.end() || !output) {
+            qCDebug(DISMAN) << "Mode list of output" << id << "not known.";
+            return false;
+        }
+
+        ModeMap modes;
+        for (auto const& [key, mode] : table->second) {
+            modes.insert({key, mode->clone()});
+        }
+        output->set_modes(modes);
+    }
+    return true;
 }
 
 void BackendManager::backend_service_unregistered(const QString& service_name)
@@ -421,7 +673,13 @@ void BackendManager::invalidate_interface()
     Q_ASSERT(mMethod == OutOfProcess);
     delete mInterface;
     mInterface = nullptr;
+    mSharedConfig->unmap();
+    invalidate_cached_config();
     mBackendService.clear();
+
+    // A new launcher does not know about our subscription.
+    mModeTables.clear();
+    mRefreshPending = false;
 }
 
 ConfigPtr BackendManager::config() const
@@ -434,6 +692,51 @@ void BackendManager::set_config(ConfigPtr c)
     mConfig = c;
 }
 
+ConfigPtr BackendManager::cached_config() const
+{
+    if (mMethod != OutOfProcess || !mInterface || !mConfigCached
+        || !(mCachedConfigStamp == config_stamp())) {
+        return ConfigPtr();
+    }
+    return mConfig;
+}
+
+BackendManager::ConfigStamp BackendManager::config_stamp() const
+{
+    ConfigStamp stamp;
+    stamp.generation = mConfigGeneration;
+    if (mSharedConfig->mapped()) {
+        stamp.published = mSharedConfig->current_generation(stamp.server_generation);
+    }
+    return stamp;
+}
+
+void BackendManager::update_cached_config(ConfigPtr const& config, ConfigStamp const& stamp)
+{
+    if (!config) {
+        return;
+    }
+
+    if (stamp.generation != mConfigGeneration) {
+        if (!mConfig) {
+            // A set operation raced the initial request. A change signal does not follow when the
+            // set operation changed nothing, so keep the config but do not serve it as cached.
+            mConfig = config->clone();
+        }
+        return;
+    }
+
+    // The config is handed out to others. Keep our own copy.
+    mConfig = config->clone();
+    mCachedConfigStamp = stamp;
+    mConfigCached = stamp.published && stamp == config_stamp();
+}
+
+void BackendManager::invalidate_cached_config()
+{
+    mConfigGeneration++;
+}
+
 void BackendManager::shutdown_backend()
 {
     if (mMethod == InProcess) {
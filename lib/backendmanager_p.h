@@ -31,9 +31,13 @@
 #include <QFileInfoList>
 #include <QObject>
 #include <QPluginLoader>
+#include <QPointer>
 #include <QProcess>
 #include <QTimer>
 
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
 
 #include "disman_export.h"
@@ -46,6 +50,15 @@ namespace Disman
 {
 
 class Backend;
+class ConfigOperation;
+class ConfigSnapshotReader;
+class GetConfigOperation;
+
+namespace ConfigSerializer
+{
+struct DBusConfig;
+struct DBusCompactConfig;
+}
 
 class DISMAN_EXPORT BackendManager : public QObject
 {
@@ -60,6 +73,49 @@ public:
     Disman::ConfigPtr config() const;
     void set_config(Disman::ConfigPtr c);
 
+    /**
+     * Identifies the state of the backend config at some point in time.
+     */
+    struct ConfigStamp {
+        // Increases with every known or possible change of the backend config in this process.
+        uint64_t generation{0};
+
+        // The generation the launcher published its config with in shared memory. Only set when
+        // the published config is current.
+        uint64_t server_generation{0};
+        bool published{false};
+
+        bool operator==(ConfigStamp const& other) const
+        {
+            return generation == other.generation && server_generation == other.server_generation
+                && published == other.published;
+        }
+    };
+
+    /**
+     * The config last received from the out-of-process backend. Null if it can not be proven
+     * current. That is the case when the launcher does not publish its config in shared memory,
+     * published a newer one or announced a pending change, or when a set operation is running.
+     */
+    Disman::ConfigPtr cached_config() const;
+
+    ConfigStamp config_stamp() const;
+
+    /**
+     * Stores @p config as cached config if the backend config has not changed since @p stamp was
+     * taken.
+     */
+    void update_cached_config(Disman::ConfigPtr const& config, ConfigStamp const& stamp);
+    void invalidate_cached_config();
+
+    /**
+     * Reads the config the out-of-process backend published in shared memory.
+     *
+     * @param generation set to the generation of the config, as announced by configDelta
+     * @return the config or null if no shared memory region is mapped or it could not be read
+     */
+    Disman::ConfigPtr shared_config(uint64_t& generation) const;
+
     /** Choose which backend to use
      *
      * This method uses a couple of heuristics to pick the backend to be loaded:
@@ -104,6 +160,11 @@ public:
     void request_backend();
     void shutdown_backend();
 
+    /**
+     * Subscribes to configDelta from now on. Otherwise the launcher does not send it here.
+     */
+    void request_config_deltas();
+
 Q_SIGNALS:
     void backend_ready(OrgKwinftDismanBackendInterface* backend);
 
@@ -126,6 +187,18 @@ private:
 
     // For out-of-process operation
     void invalidate_interface();
+    void backend_config_changed(Disman::ConfigSerializer::DBusConfig const& config);
+    void refresh_config();
+    void config_refreshed(Disman::ConfigOperation* operation);
+    void subscribe_config_changes();
+    void config_changes_subscribed(QDBusPendingCallWatcher* watcher);
+    void backend_compact_config_changed(Disman::ConfigSerializer::DBusCompactConfig const& config);
+    void request_shared_config();
+    void shared_config_received(QDBusPendingCallWatcher* watcher);
+    void shared_config_published(qulonglong generation);
+    void set_mode_tables(ConfigPtr const& config);
+    bool restore_omitted_modes(ConfigPtr const& config,
+                               std::map<int, uint64_t> const& omitted_mode_tables) const;
 
     static const int sMaxCrashCount;
     OrgKwinftDismanBackendInterface* mInterface;
@@ -134,6 +207,26 @@ private:
     QString mBackendService;
     QDBusServiceWatcher mServiceWatcher;
     Disman::ConfigPtr mConfig;
+
+    // Mode tables of the last compact config received from the launcher by their fingerprints.
+    // The launcher omits them in the next one.
+    std::map<uint64_t, ModeMap> mModeTables;
+    bool mConfigDeltas{false};
+
+    // Gets the full config when it can not be read otherwise. Only one runs at a time, further
+    // requests meanwhile start another one once it finished.
+    QPointer<GetConfigOperation> mRefreshOperation;
+    bool mRefreshPending{false};
+
+    uint64_t mConfigGeneration{0};
+    ConfigStamp mCachedConfigStamp;
+    bool mConfigCached{false};
+
+    // When mapped the cached config is read from here on configPublished. Changes are then not
+    // received anymore with configChangedCompact or configChanged.
+    std::unique_ptr<ConfigSnapshotReader> mSharedConfig;
+    QPointer<QDBusPendingCallWatcher> mSharedConfigWatcher;
+
     QTimer mResetCrashCountTimer;
     bool mShuttingDown;
     int mRequestsCounter;
@@ -19,6 +19,7 @@
 #include "config.h"
 #include "backend.h"
 #include "backendmanager_p.h"
+#include "configdiff.h"
 #include "disman_debug.h"
 #include "output.h"
 
@@ -27,7 +28,10 @@
 #include <QRect>
 #include <QStringList>
 
+#include <algorithm>
 #include <sstream>
+#include <string>
+#include <vector>
 
 using namespace Disman;
 
@@ -64,12 +68,48 @@ public:
             q->set_primary_output(OutputPtr());
         }
         output->disconnect(q);
+        hash_valid = false;
 
         Q_EMIT q->output_removed(outputId);
 
         return iter;
     }
 
+    void update_hash() const
+    {
+        if (hash_valid) {
+            return;
+        }
+
+        std::vector<std::string> output_hashes;
+        output_hashes.reserve(outputs.size());
+        for (auto const& [key, output] : outputs) {
+            output_hashes.push_back(output->hash());
+        }
+        std::sort(output_hashes.begin(), output_hashes.end());
+
+        QCryptographicHash md5(QCryptographicHash::Md5);
+
+        // 64-bit FNV-1a. Output hashes are separated by a zero byte.
+        uint64_t fnv = 0xcbf29ce484222325;
+        auto const fnv_add = [&fnv](char byte) {
+            fnv ^= static_cast<unsigned char>(byte);
+            fnv *= 0x100000001b3;
+        };
+
+        for (auto const& output_hash : output_hashes) {
+            md5.addData(QByteArray::fromRawData(output_hash.data(), output_hash.size()));
+            for (auto byte : output_hash) {
+                fnv_add(byte);
+            }
+            fnv_add('\0');
+        }
+
+        hash = QString::fromLatin1(md5.result().toHex());
+        fast_hash = fnv;
+        hash_valid = true;
+    }
+
     bool valid;
     ScreenPtr screen;
     OutputPtr primary_output;
@@ -79,6 +119,10 @@ public:
     bool tablet_mode_engaged;
     Cause cause;
 
+    mutable QString hash;
+    mutable uint64_t fast_hash{0};
+    mutable bool hash_valid{false};
+
 private:
     Config* q;
 };
@@ -104,7 +148,7 @@ bool Config::can_be_applied(const ConfigPtr& config, ValidityFlags flags)
     OutputPtr currentOutput;
     int enabledOutputsCount = 0;
 
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         if (!output->enabled()) {
             continue;
         }
@@ -228,7 +272,8 @@ bool Config::compare(ConfigPtr config) const
         return false;
     }
 
-    auto const simple_data_compare = d->valid == config->d->valid && hash() == config->hash()
+    auto const simple_data_compare = d->valid == config->d->valid
+        && fast_hash() == config->fast_hash()
         && d->supported_features == config->d->supported_features
         && d->tablet_mode_available == config->d->tablet_mode_available
         && d->tablet_mode_engaged == config->d->tablet_mode_engaged && d->cause == config->d->cause;
@@ -273,15 +318,14 @@ bool Config::compare(ConfigPtr config) const
 
 QString Config::hash() const
 {
-    QStringList hashedOutputs;
-    for (auto const& [key, output] : d->outputs) {
-        hashedOutputs << QString::fromStdString(output->hash());
-    }
+    d->update_hash();
+    return d->hash;
+}
 
-    std::sort(hashedOutputs.begin(), hashedOutputs.end());
-    const auto hash = QCryptographicHash::hash(hashedOutputs.join(QString()).toLatin1(),
-                                               QCryptographicHash::Md5);
-    return QString::fromLatin1(hash.toHex());
+uint64_t Config::fast_hash() const
+{
+    d->update_hash();
+    return d->fast_hash;
 }
 
 Config::Cause Config::cause() const
@@ -347,6 +391,11 @@ OutputMap Config::outputs() const
     return d->outputs;
 }
 
+OutputMap const& Config::output_map() const
+{
+    return d->outputs;
+}
+
 OutputPtr Config::primary_output() const
 {
     return d->primary_output;
@@ -377,6 +426,8 @@ OutputPtr Config::replication_source(OutputPtr const& output)
 void Config::add_output(const OutputPtr& output)
 {
     d->outputs.insert({output->id(), output});
+    d->hash_valid = false;
+    connect(output.get(), &Output::hash_changed, this, [this] { d->hash_valid = false; });
 
     Q_EMIT output_added(output);
 }
@@ -390,12 +441,20 @@ void Config::set_outputs(OutputMap const& outputs)
 {
     auto primary = primary_output();
     for (auto iter = d->outputs.begin(), end = d->outputs.end(); iter != end;) {
+        if (auto other = outputs.find(iter->first);
+            other != outputs.end() && other->second == iter->second) {
+            // The output is kept as it is.
+            ++iter;
+            continue;
+        }
         iter = d->remove_output(iter);
         end = d->outputs.end();
     }
 
     for (auto const& [key, output] : outputs) {
-        add_output(output);
+        if (d->outputs.find(output->id()) == d->outputs.end()) {
+            add_output(output);
+        }
         if (primary && primary->id() == output->id()) {
             set_primary_output(output);
             primary = nullptr;
@@ -439,7 +498,9 @@ void Config::apply(const ConfigPtr& other)
         } else {
             // Update existing outputs
             output = d->outputs[otherOutput->id()];
-            output->apply(otherOutput);
+            if (!!ConfigDiff::compare_outputs(*output, *otherOutput)) {
+                output->apply(otherOutput);
+            }
         }
         if (primary) {
             set_primary_output(output);
@@ -478,7 +539,7 @@ std::string Config::log() const
     if (tablet_mode_available()) {
         ss << " tablet-mode: " << (tablet_mode_engaged() ? "engaged" : "disengaged");
     }
-    for (auto const& [key, output] : outputs()) {
+    for (auto const& [key, output] : d->outputs) {
         auto log = std::istringstream(output->log());
         std::string line;
         while (std::getline(log, line)) {
@@ -27,6 +27,8 @@
 #include <QMetaType>
 #include <QObject>
 
+#include <cstdint>
+
 namespace Disman
 {
 
@@ -144,6 +146,17 @@ public:
      */
     QString hash() const;
 
+    /**
+     * Returns an identifying hash like hash() but as a non-cryptographic 64-bit digest that is
+     * cheap to compare. It is stable between sessions and can be used to name persistent data.
+     *
+     * Both hashes are cached and only recalculated when outputs are added, removed or the hash
+     * of one of the outputs changes.
+     *
+     * @return 64-bit digest of all connected outputs
+     */
+    uint64_t fast_hash() const;
+
     Cause cause() const;
     void set_cause(Cause cause);
 
@@ -153,6 +166,12 @@ public:
     OutputPtr output(int outputId) const;
     OutputMap outputs() const;
 
+    /**
+     * Same as outputs() but without copying the map. The reference stays valid as long as the
+     * config exists. Outputs must not be added or removed while iterating over it.
+     */
+    OutputMap const& output_map() const;
+
     OutputPtr primary_output() const;
     void set_primary_output(const OutputPtr& output);
 
@@ -0,0 +1,212 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "configdiff.h"
+
+#include "config.h"
+#include "output_p.h"
+#include "screen.h"
+
+#include <sstream>
+
+namespace Disman
+{
+
+ConfigDiff::ConfigDiff(ConfigPtr const& before, ConfigPtr const& after)
+{
+    if (!before || !after) {
+        if (before) {
+            for (auto const& [key, output] : before->output_map()) {
+                m_removed_outputs.push_back(output->id());
+            }
+        }
+        if (after) {
+            for (auto const& [key, output] : after->output_map()) {
+                m_added_outputs.push_back(output->id());
+            }
+        }
+        if (before || after) {
+            m_config_fields = ConfigField::Valid;
+        }
+        return;
+    }
+
+    auto set_field = [this](ConfigField field, bool changed) {
+        if (changed) {
+            m_config_fields |= field;
+        }
+    };
+
+    set_field(ConfigField::Valid, before->valid() != after->valid());
+    set_field(ConfigField::Cause, before->cause() != after->cause());
+    set_field(ConfigField::Features, before->supported_features() != after->supported_features());
+    set_field(ConfigField::TabletModeAvailable,
+              before->tablet_mode_available() != after->tablet_mode_available());
+    set_field(ConfigField::TabletModeEngaged,
+              before->tablet_mode_engaged() != after->tablet_mode_engaged());
+
+    auto const before_screen = before->screen();
+    auto const after_screen = after->screen();
+    set_field(ConfigField::Screen,
+              before_screen ? !before_screen->compare(after_screen)
+                            : static_cast<bool>(after_screen));
+
+    auto const before_primary = before->primary_output();
+    auto const after_primary = after->primary_output();
+    set_field(ConfigField::PrimaryOutput,
+              before_primary
+                  ? !after_primary || before_primary->id() != after_primary->id()
+                  : static_cast<bool>(after_primary));
+
+    auto const& before_outputs = before->output_map();
+    auto const& after_outputs = after->output_map();
+
+    for (auto const& [key, output] : before_outputs) {
+        auto other = after->output(output->id());
+        if (!other) {
+            m_removed_outputs.push_back(output->id());
+            continue;
+        }
+        auto const fields = compare_outputs(*output, *other);
+        if (!!fields) {
+            m_changed_outputs[output->id()] = fields;
+        }
+    }
+    for (auto const& [key, output] : after_outputs) {
+        if (!before->output(output->id())) {
+            m_added_outputs.push_back(output->id());
+        }
+    }
+}
+
+ConfigDiff::Fields ConfigDiff::compare_outputs(Output const& before, Output const& after)
+{
+    auto const& bd = *before.d;
+    auto const& ad = *after.d;
+
+    Fields fields;
+    auto set_field = [&fields](Field field, bool changed) {
+        if (changed) {
+            fields |= field;
+        }
+    };
+
+    set_field(Field::Name, bd.name != ad.name);
+    set_field(Field::Description, bd.description != ad.description);
+    set_field(Field::Hash, bd.hash != ad.hash);
+    set_field(Field::Type, bd.type != ad.type);
+
+    // Clones share their mode tables as long as these are not handed out.
+    set_field(Field::Modes,
+              bd.mode_table != ad.mode_table
+                  && !Output::Private::compareModeMap(bd.modes(), ad.modes()));
+    set_field(Field::PreferredModes,
+              bd.preferred_modes != ad.preferred_modes || bd.preferredMode != ad.preferredMode);
+
+    set_field(Field::ReplicationSource, bd.replication_source != ad.replication_source);
+    set_field(Field::Resolution, bd.resolution != ad.resolution);
+    set_field(Field::RefreshRate, bd.refresh_rate != ad.refresh_rate);
+    set_field(Field::AdaptiveSync, bd.adapt_sync != ad.adapt_sync);
+    set_field(Field::AdaptiveSyncToggleSupport,
+              bd.supports_adapt_sync_toggle != ad.supports_adapt_sync_toggle);
+    set_field(Field::PhysicalSize, bd.physical_size != ad.physical_size);
+    set_field(Field::Position, bd.position != ad.position);
+    set_field(Field::Geometry, bd.enforced_geometry != ad.enforced_geometry);
+    set_field(Field::Rotation, bd.rotation != ad.rotation);
+    set_field(Field::Scale, bd.scale != ad.scale);
+    set_field(Field::Enabled, bd.enabled != ad.enabled);
+    set_field(Field::FollowPreferredMode, bd.follow_preferred_mode != ad.follow_preferred_mode);
+    set_field(Field::AutoResolution, bd.auto_resolution != ad.auto_resolution);
+    set_field(Field::AutoRefreshRate, bd.auto_refresh_rate != ad.auto_refresh_rate);
+    set_field(Field::AutoRotate, bd.auto_rotate != ad.auto_rotate);
+    set_field(Field::AutoRotateOnlyInTabletMode,
+              bd.auto_rotate_only_in_tablet_mode != ad.auto_rotate_only_in_tablet_mode);
+    set_field(Field::Retention, bd.retention != ad.retention);
+
+    auto const& bg = bd.global;
+    auto const& ag = ad.global;
+    auto const global_data_compare = bg.resolution == ag.resolution && bg.refresh == ag.refresh
+        && bg.adapt_sync == ag.adapt_sync && bg.rotation == ag.rotation && bg.scale == ag.scale
+        && bg.auto_resolution == ag.auto_resolution
+        && bg.auto_refresh_rate == ag.auto_refresh_rate && bg.auto_rotate == ag.auto_rotate
+        && bg.auto_rotate_only_in_tablet_mode == ag.auto_rotate_only_in_tablet_mode
+        && bg.valid == ag.valid;
+    set_field(Field::GlobalData, !global_data_compare);
+
+    return fields;
+}
+
+bool ConfigDiff::empty() const
+{
+    return !m_config_fields && m_added_outputs.empty() && m_removed_outputs.empty()
+        && m_changed_outputs.empty();
+}
+
+ConfigDiff::ConfigFields ConfigDiff::config_fields() const
+{
+    return m_config_fields;
+}
+
+std::vector<int> const& ConfigDiff::added_outputs() const
+{
+    return m_added_outputs;
+}
+
+std::vector<int> const& ConfigDiff::removed_outputs() const
+{
+    return m_removed_outputs;
+}
+
+std::map<int, ConfigDiff::Fields> const& ConfigDiff::changed_outputs() const
+{
+    return m_changed_outputs;
+}
+
+ConfigDiff::Fields ConfigDiff::changed_fields(int output_id) const
+{
+    if (auto it = m_changed_outputs.find(output_id); it != m_changed_outputs.end()) {
+        return it->second;
+    }
+    return Field::None;
+}
+
+std::string ConfigDiff::log() const
+{
+    auto stream_ids = [](std::vector<int> const& ids) {
+        std::stringstream ss;
+        auto comma{false};
+        for (auto id : ids) {
+            if (comma) {
+                ss << ", ";
+            }
+            ss << id;
+            comma = true;
+        }
+        return ss.str();
+    };
+
+    std::stringstream ss;
+    ss << "Config diff {";
+    if (empty()) {
+        ss << " empty }";
+        return ss.str();
+    }
+
+    ss << std::endl << "  config fields: 0x" << std::hex << m_config_fields.toInt() << std::dec;
+    if (!m_added_outputs.empty()) {
+        ss << std::endl << "  added: " << stream_ids(m_added_outputs);
+    }
+    if (!m_removed_outputs.empty()) {
+        ss << std::endl << "  removed: " << stream_ids(m_removed_outputs);
+    }
+    for (auto const& [id, fields] : m_changed_outputs) {
+        ss << std::endl
+           << "  output " << id << " fields: 0x" << std::hex << fields.toInt() << std::dec;
+    }
+    ss << std::endl << "}";
+    return ss.str();
+}
+
+}
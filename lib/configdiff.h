@@ -0,0 +1,117 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "disman_export.h"
+#include "types.h"
+
+#include <QFlags>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Disman
+{
+
+/**
+ * Describes the differences between two configs.
+ *
+ * Outputs are matched by their ids. For outputs that exist in both configs the changed fields are
+ * listed. Outputs without changes are not part of the diff.
+ */
+class DISMAN_EXPORT ConfigDiff
+{
+public:
+    enum class Field {
+        None = 0,
+        Name = 1,
+        Description = 1 << 1,
+        Hash = 1 << 2,
+        Type = 1 << 3,
+        Modes = 1 << 4,
+        PreferredModes = 1 << 5,
+        ReplicationSource = 1 << 6,
+        Resolution = 1 << 7,
+        RefreshRate = 1 << 8,
+        AdaptiveSync = 1 << 9,
+        AdaptiveSyncToggleSupport = 1 << 10,
+        PhysicalSize = 1 << 11,
+        Position = 1 << 12,
+        Geometry = 1 << 13, ///< Geometry enforced by the backend.
+        Rotation = 1 << 14,
+        Scale = 1 << 15,
+        Enabled = 1 << 16,
+        FollowPreferredMode = 1 << 17,
+        AutoResolution = 1 << 18,
+        AutoRefreshRate = 1 << 19,
+        AutoRotate = 1 << 20,
+        AutoRotateOnlyInTabletMode = 1 << 21,
+        Retention = 1 << 22,
+        GlobalData = 1 << 23,
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
+    enum class ConfigField {
+        None = 0,
+        Valid = 1,
+        Cause = 1 << 1,
+        Features = 1 << 2,
+        TabletModeAvailable = 1 << 3,
+        TabletModeEngaged = 1 << 4,
+        Screen = 1 << 5,
+        PrimaryOutput = 1 << 6,
+    };
+    Q_DECLARE_FLAGS(ConfigFields, ConfigField)
+
+    /**
+     * Creates the diff of going from @param before to @param after. If one of them is null all
+     * outputs of the other one count as added or removed.
+     */
+    ConfigDiff(ConfigPtr const& before, ConfigPtr const& after);
+
+    /**
+     * Compares two outputs field by field. The output ids are not compared.
+     *
+     * @return the fields with different values
+     */
+    static Fields compare_outputs(Output const& before, Output const& after);
+
+    /**
+     * @return true when there are no differences at all
+     */
+    bool empty() const;
+
+    ConfigFields config_fields() const;
+
+    std::vector<int> const& added_outputs() const;
+    std::vector<int> const& removed_outputs() const;
+
+    /**
+     * @return ids of outputs that exist in both configs and have changed together with the
+     * changed fields
+     */
+    std::map<int, Fields> const& changed_outputs() const;
+
+    /**
+     * @return the changed fields of the output with @param output_id or None when it has not
+     * changed or does not exist in both configs
+     */
+    Fields changed_fields(int output_id) const;
+
+    std::string log() const;
+
+private:
+    ConfigFields m_config_fields;
+    std::vector<int> m_added_outputs;
+    std::vector<int> m_removed_outputs;
+    std::map<int, Fields> m_changed_outputs;
+};
+
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Disman::ConfigDiff::Fields)
+Q_DECLARE_OPERATORS_FOR_FLAGS(Disman::ConfigDiff::ConfigFields)
@@ -21,10 +21,12 @@
 #include "backendmanager_p.h"
 #include "configserializer_p.h"
 #include "disman_debug.h"
-#include "getconfigoperation.h"
 #include "output.h"
 
 #include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+#include <map>
 
 Q_DECLARE_SMART_POINTER_METATYPE(std::shared_ptr)
 
@@ -39,9 +41,11 @@ public:
 
     void update_configs();
     void on_backend_ready(org::kwinft::disman::backend* backend);
-    void backend_config_changed(const QVariantMap& configMap);
+    void backend_config_delta(qulonglong generation, const QVariantMap& delta);
+    void request_snapshot(bool update);
+    void snapshot_received(QDBusPendingCallWatcher* watcher);
+    void apply_snapshot(ConfigPtr const& config, qulonglong generation);
     void config_destroyed(QObject* removedConfig);
-    void get_config_finished(ConfigOperation* op);
     void update_configs(const Disman::ConfigPtr& newConfig);
     bool has_config(ConfigPtr const& config) const;
 
@@ -50,6 +54,15 @@ public:
     QPointer<org::kwinft::disman::backend> mBackend;
     bool mFirstBackend;
 
+    // Last known backend config. Deltas from the backend are applied onto it in order of their
+    // generation. On a gap in the generations a full snapshot is requested.
+    ConfigPtr base_config;
+    qulonglong base_generation{0};
+
+    QPointer<QDBusPendingCallWatcher> snapshot_watcher;
+    bool update_after_snapshot{false};
+    std::map<qulonglong, QVariantMap> pending_deltas;
+
 private:
     ConfigMonitor* q;
 };
@@ -70,56 +83,147 @@ void ConfigMonitor::Private::on_backend_ready(org::kwinft::disman::backend* back
 
     if (mBackend) {
         disconnect(mBackend.data(),
-                   &org::kwinft::disman::backend::configChanged,
+                   &org::kwinft::disman::backend::configDelta,
                    this,
-                   &ConfigMonitor::Private::backend_config_changed);
+                   &ConfigMonitor::Private::backend_config_delta);
     }
 
     mBackend = QPointer<org::kwinft::disman::backend>(backend);
+
+    base_config.reset();
+    base_generation = 0;
+    pending_deltas.clear();
+    delete snapshot_watcher;
+    update_after_snapshot = false;
+
+    if (!mBackend) {
+        return;
+    }
+
+    connect(mBackend.data(),
+            &org::kwinft::disman::backend::configDelta,
+            this,
+            &ConfigMonitor::Private::backend_config_delta);
+    // The launcher only sends deltas to subscribed clients.
+    BackendManager::instance()->request_config_deltas();
+
     // If we received a new backend interface, then it's very likely that it is
     // because the backend process has crashed - just to be sure we haven't missed
-    // any change, request the current config now and update our watched configs
+    // any change, update our watched configs with the snapshot.
     //
-    // Only request the config if this is not initial backend request, because it
+    // Only update the configs if this is not initial backend request, because it
     // can happen that if a change happened before now, or before we get the config,
     // the result will be invalid. This can happen when Disman KDED launches and
     // detects changes need to be done.
-    if (!mFirstBackend && !watched_configs.isEmpty()) {
-        connect(new GetConfigOperation(),
-                &GetConfigOperation::finished,
-                this,
-                &Private::get_config_finished);
-    }
+    request_snapshot(!mFirstBackend && !watched_configs.isEmpty());
     mFirstBackend = false;
-
-    connect(mBackend.data(),
-            &org::kwinft::disman::backend::configChanged,
-            this,
-            &ConfigMonitor::Private::backend_config_changed);
 }
 
-void ConfigMonitor::Private::get_config_finished(ConfigOperation* op)
+void ConfigMonitor::Private::backend_config_delta(qulonglong generation, const QVariantMap& delta)
 {
     Q_ASSERT(BackendManager::instance()->method() == BackendManager::OutOfProcess);
-    if (op->has_error()) {
-        qCWarning(DISMAN) << "Failed to retrieve current config: " << op->error_string();
+
+    if (snapshot_watcher) {
+        pending_deltas.insert({generation, delta});
         return;
     }
 
-    const Disman::ConfigPtr config = qobject_cast<GetConfigOperation*>(op)->config();
-    update_configs(config);
+    if (!base_config || generation != base_generation + 1) {
+        qCDebug(DISMAN) << "Missed config generation" << base_generation + 1
+                        << "- requesting snapshot.";
+        pending_deltas.insert({generation, delta});
+        request_snapshot(true);
+        return;
+    }
+
+    if (!ConfigSerializer::apply_config_delta(base_config, delta)) {
+        qCWarning(DISMAN) << "Failed to apply config delta from DBus change notification";
+        base_config.reset();
+        request_snapshot(true);
+        return;
+    }
+
+    base_generation = generation;
+    update_configs(base_config);
 }
 
-void ConfigMonitor::Private::backend_config_changed(const QVariantMap& configMap)
+void ConfigMonitor::Private::request_snapshot(bool update)
 {
-    Q_ASSERT(BackendManager::instance()->method() == BackendManager::OutOfProcess);
+    update_after_snapshot |= update;
+
+    if (snapshot_watcher || !mBackend) {
+        return;
+    }
+
+    // Prefer the config in shared memory if it is recent enough to cover all pending deltas.
+    uint64_t generation;
+    if (auto config = BackendManager::instance()->shared_config(generation)) {
+        if (pending_deltas.empty() || generation >= pending_deltas.rbegin()->first) {
+            apply_snapshot(config, generation);
+            return;
+        }
+    }
+
+    snapshot_watcher = new QDBusPendingCallWatcher(mBackend->getConfigSnapshot(), this);
+    connect(snapshot_watcher,
+            &QDBusPendingCallWatcher::finished,
+            this,
+            &ConfigMonitor::Private::snapshot_received);
+}
+
+void ConfigMonitor::Private::snapshot_received(QDBusPendingCallWatcher* watcher)
+{
+    watcher->deleteLater();
+    if (watcher != snapshot_watcher) {
+        return;
+    }
+    snapshot_watcher.clear();
 
-    ConfigPtr newConfig = ConfigSerializer::deserialize_config(configMap);
-    if (!newConfig) {
-        qCWarning(DISMAN) << "Failed to deserialize config from DBus change notification";
+    QDBusPendingReply<qulonglong, ConfigSerializer::DBusConfig> reply = *watcher;
+    if (reply.isError()) {
+        qCWarning(DISMAN) << "Failed to retrieve config snapshot:" << reply.error().message();
+        pending_deltas.clear();
         return;
     }
-    update_configs(newConfig);
+
+    auto config = reply.argumentAt<1>().config;
+    if (!config) {
+        qCWarning(DISMAN) << "Failed to deserialize config snapshot";
+        pending_deltas.clear();
+        return;
+    }
+
+    apply_snapshot(config, reply.argumentAt<0>());
+}
+
+void ConfigMonitor::Private::apply_snapshot(ConfigPtr const& config, qulonglong generation)
+{
+    base_config = config;
+    base_generation = generation;
+
+    auto update = update_after_snapshot;
+    update_after_snapshot = false;
+
+    auto deltas = std::move(pending_deltas);
+    pending_deltas.clear();
+
+    for (auto const& [delta_generation, delta] : deltas) {
+        if (delta_generation <= base_generation) {
+            continue;
+        }
+        if (delta_generation != base_generation + 1
+            || !ConfigSerializer::apply_config_delta(base_config, delta)) {
+            base_config.reset();
+            request_snapshot(true);
+            return;
+        }
+        base_generation = delta_generation;
+        update = true;
+    }
+
+    if (update) {
+        update_configs(base_config);
+    }
 }
 
 void ConfigMonitor::Private::update_configs(const Disman::ConfigPtr& newConfig)
@@ -23,7 +23,11 @@
 #include "mode.h"
 #include "screen.h"
 
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
 #include <QDBusArgument>
+#include <QDBusMetaType>
 #include <QFile>
 #include <QJsonDocument>
 #include <QRect>
@@ -72,7 +76,7 @@ QJsonObject ConfigSerializer::serialize_config(const ConfigPtr& config)
     }
 
     QJsonArray outputs;
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         outputs.append(serialize_output(output));
     }
     obj[QLatin1String("outputs")] = outputs;
@@ -86,54 +90,111 @@ QJsonObject ConfigSerializer::serialize_config(const ConfigPtr& config)
     return obj;
 }
 
-QJsonObject ConfigSerializer::serialize_output(const OutputPtr& output)
+namespace
+{
+
+using Field = ConfigDiff::Field;
+using Fields = ConfigDiff::Fields;
+
+Fields const all_output_fields = Fields(QFlag(~0));
+
+// Fields of which a change may alter the mode an output is set to.
+Fields const mode_fields = Fields(Field::Modes) | Field::PreferredModes | Field::FollowPreferredMode
+    | Field::Resolution | Field::RefreshRate | Field::AutoResolution | Field::AutoRefreshRate;
+
+QJsonObject serialize_output_fields(OutputPtr const& output, Fields fields)
 {
     QJsonObject obj;
 
     obj[QLatin1String("id")] = output->id();
-    obj[QLatin1String("name")] = QString::fromStdString(output->name());
-    obj[QLatin1String("description")] = QString::fromStdString(output->description());
-    obj[QLatin1String("hash")] = QString::fromStdString(output->hash());
-    obj[QLatin1String("type")] = static_cast<int>(output->type());
-    obj[QLatin1String("position")] = serialize_point(output->position());
-    obj[QLatin1String("scale")] = output->scale();
-    obj[QLatin1String("rotation")] = static_cast<int>(output->rotation());
 
-    auto const mode = output->auto_mode();
-    assert(mode);
-    obj[QLatin1String("resolution")] = serialize_size(mode->size());
-    obj[QLatin1String("refresh")] = mode->refresh();
+    if (fields.testFlag(Field::Name)) {
+        obj[QLatin1String("name")] = QString::fromStdString(output->name());
+    }
+    if (fields.testFlag(Field::Description)) {
+        obj[QLatin1String("description")] = QString::fromStdString(output->description());
+    }
+    if (fields.testFlag(Field::Hash)) {
+        obj[QLatin1String("hash")] = QString::fromStdString(output->hash());
+    }
+    if (fields.testFlag(Field::Type)) {
+        obj[QLatin1String("type")] = static_cast<int>(output->type());
+    }
+    if (fields.testFlag(Field::Position)) {
+        obj[QLatin1String("position")] = ConfigSerializer::serialize_point(output->position());
+    }
+    if (fields.testFlag(Field::Scale)) {
+        obj[QLatin1String("scale")] = output->scale();
+    }
+    if (fields.testFlag(Field::Rotation)) {
+        obj[QLatin1String("rotation")] = static_cast<int>(output->rotation());
+    }
 
-    QStringList mode_q_strings;
-    for (auto const& mode_string : output->preferred_modes()) {
-        mode_q_strings.push_back(QString::fromStdString(mode_string));
+    if (!!(fields & mode_fields)) {
+        auto const mode = output->auto_mode();
+        assert(mode);
+        obj[QLatin1String("resolution")] = ConfigSerializer::serialize_size(mode->size());
+        obj[QLatin1String("refresh")] = mode->refresh();
     }
-    obj[QLatin1String("preferred_modes")] = serialize_list(mode_q_strings);
 
-    obj[QLatin1String("follow_preferred_mode")] = output->follow_preferred_mode();
-    obj[QLatin1String("enabled")] = output->enabled();
-    obj[QLatin1String("physical_size")] = serialize_size(output->physical_size());
-    obj[QLatin1String("replication_source")] = output->replication_source();
-    obj[QLatin1String("auto_rotate")] = output->auto_rotate();
-    obj[QLatin1String("auto_rotate_only_in_tablet_mode")]
-        = output->auto_rotate_only_in_tablet_mode();
-    obj[QLatin1String("auto_resolution")] = output->auto_resolution();
-    obj[QLatin1String("auto_refresh_rate")] = output->auto_refresh_rate();
-    obj[QLatin1String("retention")] = static_cast<int>(output->retention());
-    obj[QLatin1String("adaptive_sync_toggle_support")] = output->adaptive_sync_toggle_support();
-    obj[QLatin1String("adaptive_sync")] = output->adaptive_sync();
+    if (fields.testFlag(Field::PreferredModes)) {
+        QStringList mode_q_strings;
+        for (auto const& mode_string : output->preferred_modes()) {
+            mode_q_strings.push_back(QString::fromStdString(mode_string));
+        }
+        obj[QLatin1String("preferred_modes")] = ConfigSerializer::serialize_list(mode_q_strings);
+    }
 
-    QJsonArray modes;
-    for (auto const& [key, mode] : output->modes()) {
-        modes.append(serialize_mode(mode));
+    if (fields.testFlag(Field::FollowPreferredMode)) {
+        obj[QLatin1String("follow_preferred_mode")] = output->follow_preferred_mode();
+    }
+    if (fields.testFlag(Field::Enabled)) {
+        obj[QLatin1String("enabled")] = output->enabled();
+    }
+    if (fields.testFlag(Field::PhysicalSize)) {
+        obj[QLatin1String("physical_size")]
+            = ConfigSerializer::serialize_size(output->physical_size());
+    }
+    if (fields.testFlag(Field::ReplicationSource)) {
+        obj[QLatin1String("replication_source")] = output->replication_source();
+    }
+    if (fields.testFlag(Field::AutoRotate)) {
+        obj[QLatin1String("auto_rotate")] = output->auto_rotate();
+    }
+    if (fields.testFlag(Field::AutoRotateOnlyInTabletMode)) {
+        obj[QLatin1String("auto_rotate_only_in_tablet_mode")]
+            = output->auto_rotate_only_in_tablet_mode();
+    }
+    if (fields.testFlag(Field::AutoResolution)) {
+        obj[QLatin1String("auto_resolution")] = output->auto_resolution();
+    }
+    if (fields.testFlag(Field::AutoRefreshRate)) {
+        obj[QLatin1String("auto_refresh_rate")] = output->auto_refresh_rate();
+    }
+    if (fields.testFlag(Field::Retention)) {
+        obj[QLatin1String("retention")] = static_cast<int>(output->retention());
+    }
+    if (fields.testFlag(Field::AdaptiveSyncToggleSupport)) {
+        obj[QLatin1String("adaptive_sync_toggle_support")]
+            = output->adaptive_sync_toggle_support();
+    }
+    if (fields.testFlag(Field::AdaptiveSync)) {
+        obj[QLatin1String("adaptive_sync")] = output->adaptive_sync();
+    }
+
+    if (fields.testFlag(Field::Modes)) {
+        QJsonArray modes;
+        for (auto const& [key, mode] : output->mode_map()) {
+            modes.append(ConfigSerializer::serialize_mode(mode));
+        }
+        obj[QLatin1String("modes")] = modes;
     }
-    obj[QLatin1String("modes")] = modes;
 
     auto data = output->global_data();
-    if (data.valid) {
+    if (fields.testFlag(Field::GlobalData) && data.valid) {
         obj[QLatin1String("global")] = true;
 
-        obj[QLatin1String("global.resolution")] = serialize_size(data.resolution);
+        obj[QLatin1String("global.resolution")] = ConfigSerializer::serialize_size(data.resolution);
         obj[QLatin1String("global.refresh")] = data.refresh;
 
         obj[QLatin1String("global.rotation")] = data.rotation;
@@ -150,7 +211,90 @@ QJsonObject ConfigSerializer::serialize_output(const OutputPtr& output)
     return obj;
 }
 
-QJsonObject ConfigSerializer::serialize_mode(const ModePtr& mode)
+}
+
+QJsonObject ConfigSerializer::serialize_output(const OutputPtr& output)
+{
+    return serialize_output_fields(output, all_output_fields);
+}
+
+QJsonObject ConfigSerializer::serialize_config_delta(ConfigPtr const& config,
+                                                     ConfigDiff const& diff)
+{
+    QJsonObject obj;
+
+    if (!config) {
+        return obj;
+    }
+
+    auto const config_fields = diff.config_fields();
+
+    if (config_fields.testFlag(ConfigDiff::ConfigField::Valid)) {
+        obj[QLatin1String("valid")] = config->valid();
+    }
+    if (config_fields.testFlag(ConfigDiff::ConfigField::Cause)) {
+        obj[QLatin1String("cause")] = static_cast<int>(config->cause());
+    }
+    if (config_fields.testFlag(ConfigDiff::ConfigField::Features)) {
+        obj[QLatin1String("features")] = static_cast<int>(config->supported_features());
+    }
+    if (config_fields.testFlag(ConfigDiff::ConfigField::PrimaryOutput)) {
+        auto primary = config->primary_output();
+        obj[QLatin1String("primary-output")] = primary ? primary->id() : -1;
+    }
+    if (config_fields.testFlag(ConfigDiff::ConfigField::Screen) && config->screen()) {
+        obj[QLatin1String("screen")] = serialize_screen(config->screen());
+    }
+    if (config_fields.testFlag(ConfigDiff::ConfigField::TabletModeAvailable)) {
+        obj[QLatin1String("tablet_mode_available")] = config->tablet_mode_available();
+    }
+    if (config_fields.testFlag(ConfigDiff::ConfigField::TabletModeEngaged)) {
+        obj[QLatin1String("tablet_mode_engaged")] = config->tablet_mode_engaged();
+    }
+
+    QJsonArray outputs;
+    QJsonArray changed_outputs;
+
+    for (auto id : diff.added_outputs()) {
+        if (auto output = config->output(id)) {
+            outputs.append(serialize_output(output));
+        }
+    }
+    for (auto const& [id, fields] : diff.changed_outputs()) {
+        auto output = config->output(id);
+        if (!output) {
+            continue;
+        }
+        if (fields.testFlag(Field::GlobalData)) {
+            // Global data can not be reset partially. Replace the output instead.
+            outputs.append(serialize_output(output));
+            continue;
+        }
+        auto partial = serialize_output_fields(output, fields);
+        if (partial.size() > 1) {
+            changed_outputs.append(partial);
+        }
+    }
+
+    if (!outputs.isEmpty()) {
+        obj[QLatin1String("outputs")] = outputs;
+    }
+    if (!changed_outputs.isEmpty()) {
+        obj[QLatin1String("changed_outputs")] = changed_outputs;
+    }
+
+    if (!diff.removed_outputs().empty()) {
+        QJsonArray removed;
+        for (auto id : diff.removed_outputs()) {
+            removed.append(id);
+        }
+        obj[QLatin1String("removed_outputs")] = removed;
+    }
+
+    return obj;
+}
+
+QJsonObject ConfigSerializer::serialize_mode(std::shared_ptr<Mode const> const& mode)
 {
     QJsonObject obj;
 
@@ -264,21 +408,167 @@ QSizeF ConfigSerializer::deserialize_sizef(const QDBusArgument& arg)
     return QSizeF(w, h);
 }
 
-ConfigPtr ConfigSerializer::deserialize_config(const QVariantMap& map)
+namespace
+{
+
+Config::Cause deserialize_cause(QVariant const& var)
 {
-    auto cause = static_cast<Config::Cause>(
-        map.value(QStringLiteral("cause"), static_cast<int>(Config::Cause::unknown)).toInt());
+    auto cause = static_cast<Config::Cause>(var.toInt());
     switch (cause) {
     case Config::Cause::unknown:
     case Config::Cause::generated:
     case Config::Cause::file:
     case Config::Cause::interactive:
-        break;
+        return cause;
     default:
         qCWarning(DISMAN) << "Deserialized config without valid cause value.";
-        cause = Config::Cause::unknown;
+        return Config::Cause::unknown;
+    }
+}
+
+// Values of an output map that are not set directly on the output.
+struct output_extras {
+    Output::GlobalData global;
+    uint64_t modes_fingerprint{0};
+    bool has_modes{false};
+};
+
+bool deserialize_output_value(Output& output,
+                              output_extras& extras,
+                              QString const& key,
+                              QVariant const& value)
+{
+    if (key == QLatin1String("id")) {
+        output.set_id(value.toInt());
+    } else if (key == QLatin1String("name")) {
+        output.set_name(value.toString().toStdString());
+    } else if (key == QLatin1String("description")) {
+        output.set_description(value.toString().toStdString());
+    } else if (key == QLatin1String("hash")) {
+        output.set_hash_raw(value.toString().toStdString());
+    } else if (key == QLatin1String("type")) {
+        output.setType(static_cast<Output::Type>(value.toInt()));
+    } else if (key == QLatin1String("position")) {
+        output.set_position(ConfigSerializer::deserialize_point(value.value<QDBusArgument>()));
+    } else if (key == QLatin1String("scale")) {
+        output.set_scale(value.toDouble());
+    } else if (key == QLatin1String("rotation")) {
+        output.set_rotation(static_cast<Output::Rotation>(value.toInt()));
+    } else if (key == QLatin1String("resolution")) {
+        output.set_resolution(ConfigSerializer::deserialize_size(value.value<QDBusArgument>()));
+    } else if (key == QLatin1String("refresh")) {
+        output.set_refresh_rate(value.toInt());
+    } else if (key == QLatin1String("auto_rotate")) {
+        output.set_auto_rotate(value.toBool());
+    } else if (key == QLatin1String("auto_rotate_only_in_tablet_mode")) {
+        output.set_auto_rotate_only_in_tablet_mode(value.toBool());
+    } else if (key == QLatin1String("auto_resolution")) {
+        output.set_auto_resolution(value.toBool());
+    } else if (key == QLatin1String("auto_refresh_rate")) {
+        output.set_auto_refresh_rate(value.toBool());
+    } else if (key == QLatin1String("adaptive_sync_toggle_support")) {
+        output.set_adaptive_sync_toggle_support(value.toBool());
+    } else if (key == QLatin1String("adaptive_sync")) {
+        output.set_adaptive_sync(value.toBool());
+    }
+
+    else if (key == QLatin1String("global")) {
+        extras.global.valid = true;
+    } else if (key == QLatin1String("global.resolution")) {
+        extras.global.resolution
+            = ConfigSerializer::deserialize_size(value.value<QDBusArgument>());
+    } else if (key == QLatin1String("global.refresh")) {
+        extras.global.refresh = value.toInt();
+    } else if (key == QLatin1String("global.rotation")) {
+        extras.global.rotation = static_cast<Output::Rotation>(value.toInt());
+    } else if (key == QLatin1String("global.scale")) {
+        extras.global.scale = value.toDouble();
+    } else if (key == QLatin1String("global.auto_resolution")) {
+        extras.global.auto_resolution = value.toBool();
+    } else if (key == QLatin1String("global.auto_refresh_rate")) {
+        extras.global.auto_refresh_rate = value.toBool();
+    } else if (key == QLatin1String("global.auto_rotate")) {
+        extras.global.auto_rotate = value.toBool();
+    } else if (key == QLatin1String("global.auto_rotate_only_in_tablet_mode")) {
+        extras.global.auto_rotate_only_in_tablet_mode = value.toBool();
+    }
+
+    else if (key == QLatin1String("preferred_modes")) {
+        auto q_strings
+            = ConfigSerializer::deserialize_list<QString>(value.value<QDBusArgument>());
+        std::vector<std::string> strings;
+        for (auto const& qs : q_strings) {
+            strings.push_back(qs.toStdString());
+        }
+        output.set_preferred_modes(strings);
+
+    } else if (key == QLatin1String("follow_preferred_mode")) {
+        output.set_follow_preferred_mode(value.toBool());
+    } else if (key == QLatin1String("enabled")) {
+        output.set_enabled(value.toBool());
+    } else if (key == QLatin1String("replication_source")) {
+        output.set_replication_source(value.toInt());
+    } else if (key == QLatin1String("physical_size")) {
+        output.set_physical_size(
+            ConfigSerializer::deserialize_size(value.value<QDBusArgument>()));
+    } else if (key == QLatin1String("retention")) {
+        output.set_retention(ConfigSerializer::deserialize_retention(value));
+    } else if (key == QLatin1String("modes")) {
+        const QDBusArgument arg = value.value<QDBusArgument>();
+        ModeMap modes;
+        arg.beginArray();
+        while (!arg.atEnd()) {
+            QVariant value;
+            arg >> value;
+            auto const mode
+                = ConfigSerializer::deserialize_mode(value.value<QDBusArgument>());
+            if (!mode) {
+                return false;
+            }
+            modes.insert({mode->id(), mode});
+        }
+        arg.endArray();
+        output.set_modes(modes);
+        extras.has_modes = true;
+    } else if (key == QLatin1String("modes_fingerprint")) {
+        extras.modes_fingerprint = value.toULongLong();
+    } else {
+        qCWarning(DISMAN) << "Invalid key in Output map: " << key;
+        return false;
+    }
+    return true;
+}
+
+OutputPtr deserialize_output_map(QDBusArgument const& arg, output_extras& extras)
+{
+    OutputPtr output(new Output);
+
+    arg.beginMap();
+    while (!arg.atEnd()) {
+        QString key;
+        QVariant value;
+        arg.beginMapEntry();
+        arg >> key >> value;
+        if (!deserialize_output_value(*output, extras, key, value)) {
+            return OutputPtr();
+        }
+        arg.endMapEntry();
+    }
+    arg.endMap();
+
+    if (extras.global.valid) {
+        output->set_global_data(extras.global);
     }
 
+    return output;
+}
+
+}
+
+ConfigPtr ConfigSerializer::deserialize_config(const QVariantMap& map)
+{
+    auto const cause = deserialize_cause(
+        map.value(QStringLiteral("cause"), static_cast<int>(Config::Cause::unknown)));
     ConfigPtr config(new Config(cause));
 
     if (map.contains(QLatin1String("features"))) {
@@ -333,115 +623,8 @@ ConfigPtr ConfigSerializer::deserialize_config(const QVariantMap& map)
 
 OutputPtr ConfigSerializer::deserialize_output(const QDBusArgument& arg)
 {
-    OutputPtr output(new Output);
-    Output::GlobalData global_data;
-
-    arg.beginMap();
-    while (!arg.atEnd()) {
-        QString key;
-        QVariant value;
-        arg.beginMapEntry();
-        arg >> key >> value;
-        if (key == QLatin1String("id")) {
-            output->set_id(value.toInt());
-        } else if (key == QLatin1String("name")) {
-            output->set_name(value.toString().toStdString());
-        } else if (key == QLatin1String("description")) {
-            output->set_description(value.toString().toStdString());
-        } else if (key == QLatin1String("hash")) {
-            output->set_hash_raw(value.toString().toStdString());
-        } else if (key == QLatin1String("type")) {
-            output->setType(static_cast<Output::Type>(value.toInt()));
-        } else if (key == QLatin1String("position")) {
-            output->set_position(deserialize_point(value.value<QDBusArgument>()));
-        } else if (key == QLatin1String("scale")) {
-            output->set_scale(value.toDouble());
-        } else if (key == QLatin1String("rotation")) {
-            output->set_rotation(static_cast<Output::Rotation>(value.toInt()));
-        } else if (key == QLatin1String("resolution")) {
-            output->set_resolution(deserialize_size(value.value<QDBusArgument>()));
-        } else if (key == QLatin1String("refresh")) {
-            output->set_refresh_rate(value.toInt());
-        } else if (key == QLatin1String("auto_rotate")) {
-            output->set_auto_rotate(value.toBool());
-        } else if (key == QLatin1String("auto_rotate_only_in_tablet_mode")) {
-            output->set_auto_rotate_only_in_tablet_mode(value.toBool());
-        } else if (key == QLatin1String("auto_resolution")) {
-            output->set_auto_resolution(value.toBool());
-        } else if (key == QLatin1String("auto_refresh_rate")) {
-            output->set_auto_refresh_rate(value.toBool());
-        } else if (key == QLatin1String("adaptive_sync_toggle_support")) {
-            output->set_adaptive_sync_toggle_support(value.toBool());
-        } else if (key == QLatin1String("adaptive_sync")) {
-            output->set_adaptive_sync(value.toBool());
-        }
-
-        else if (key == QLatin1String("global")) {
-            global_data.valid = true;
-        } else if (key == QLatin1String("global.resolution")) {
-            global_data.resolution = deserialize_size(value.value<QDBusArgument>());
-        } else if (key == QLatin1String("global.refresh")) {
-            global_data.refresh = value.toInt();
-        } else if (key == QLatin1String("global.rotation")) {
-            global_data.rotation = static_cast<Output::Rotation>(value.toInt());
-        } else if (key == QLatin1String("global.scale")) {
-            global_data.scale = value.toDouble();
-        } else if (key == QLatin1String("global.auto_resolution")) {
-            global_data.auto_resolution = value.toBool();
-        } else if (key == QLatin1String("global.auto_refresh_rate")) {
-            global_data.auto_refresh_rate = value.toBool();
-        } else if (key == QLatin1String("global.auto_rotate")) {
-            global_data.auto_rotate = value.toBool();
-        } else if (key == QLatin1String("global.auto_rotate_only_in_tablet_mode")) {
-            global_data.auto_rotate_only_in_tablet_mode = value.toBool();
-        }
-
-        else if (key == QLatin1String("preferred_modes")) {
-            auto q_strings = deserialize_list<QString>(value.value<QDBusArgument>());
-            std::vector<std::string> strings;
-            for (auto const& qs : q_strings) {
-                strings.push_back(qs.toStdString());
-            }
-            output->set_preferred_modes(strings);
-
-        } else if (key == QLatin1String("follow_preferred_mode")) {
-            output->set_follow_preferred_mode(value.toBool());
-        } else if (key == QLatin1String("enabled")) {
-            output->set_enabled(value.toBool());
-        } else if (key == QLatin1String("replication_source")) {
-            output->set_replication_source(value.toInt());
-        } else if (key == QLatin1String("physical_size")) {
-            output->set_physical_size(deserialize_size(value.value<QDBusArgument>()));
-        } else if (key == QLatin1String("retention")) {
-            output->set_retention(deserialize_retention(value));
-        } else if (key == QLatin1String("modes")) {
-            const QDBusArgument arg = value.value<QDBusArgument>();
-            ModeMap modes;
-            arg.beginArray();
-            while (!arg.atEnd()) {
-                QVariant value;
-                arg >> value;
-                const Disman::ModePtr mode = deserialize_mode(value.value<QDBusArgument>());
-                if (!mode) {
-                    return OutputPtr();
-                }
-                modes.insert({mode->id(), mode});
-            }
-            arg.endArray();
-            output->set_modes(modes);
-        } else {
-            qCWarning(DISMAN) << "Invalid key in Output map: " << key;
-            return OutputPtr();
-        }
-        arg.endMapEntry();
-    }
-    arg.endMap();
-
-    if (global_data.valid) {
-        output->set_global_data(global_data);
-    }
-
-    return output;
+    output_extras extras;
+    return deserialize_output_map(arg, extras);
 }
 
 ModePtr ConfigSerializer::deserialize_mode(const QDBusArgument& arg)
@@ -502,3 +685,775 @@ ScreenPtr ConfigSerializer::deserialize_screen(const QDBusArgument& arg)
     arg.endMap();
     return screen;
 }
+
+bool ConfigSerializer::apply_config_delta(ConfigPtr const& config, QVariantMap const& delta)
+{
+    if (!config) {
+        return false;
+    }
+
+    if (delta.contains(QLatin1String("valid"))) {
+        config->set_valid(delta[QStringLiteral("valid")].toBool());
+    }
+    if (delta.contains(QLatin1String("cause"))) {
+        config->set_cause(deserialize_cause(delta[QStringLiteral("cause")]));
+    }
+    if (delta.contains(QLatin1String("features"))) {
+        config->set_supported_features(
+            static_cast<Config::Features>(delta[QStringLiteral("features")].toInt()));
+    }
+    if (delta.contains(QLatin1String("tablet_mode_available"))) {
+        config->set_tablet_mode_available(delta[QStringLiteral("tablet_mode_available")].toBool());
+    }
+    if (delta.contains(QLatin1String("tablet_mode_engaged"))) {
+        config->set_tablet_mode_engaged(delta[QStringLiteral("tablet_mode_engaged")].toBool());
+    }
+
+    if (delta.contains(QLatin1String("removed_outputs"))) {
+        auto const& ids_arg = delta[QStringLiteral("removed_outputs")].value<QDBusArgument>();
+        for (auto id : deserialize_list<int>(ids_arg)) {
+            config->remove_output(id);
+        }
+    }
+
+    if (delta.contains(QLatin1String("outputs"))) {
+        const QDBusArgument& outputsArg = delta[QStringLiteral("outputs")].value<QDBusArgument>();
+        outputsArg.beginArray();
+        while (!outputsArg.atEnd()) {
+            QVariant value;
+            outputsArg >> value;
+            auto const output = deserialize_output(value.value<QDBusArgument>());
+            if (!output) {
+                return false;
+            }
+            auto const was_primary = config->primary_output()
+                && config->primary_output()->id() == output->id();
+            config->remove_output(output->id());
+            config->add_output(output);
+            if (was_primary) {
+                config->set_primary_output(output);
+            }
+        }
+        outputsArg.endArray();
+    }
+
+    if (delta.contains(QLatin1String("changed_outputs"))) {
+        const QDBusArgument& outputsArg
+            = delta[QStringLiteral("changed_outputs")].value<QDBusArgument>();
+        outputsArg.beginArray();
+        while (!outputsArg.atEnd()) {
+            QVariant value;
+            outputsArg >> value;
+            auto const map = qdbus_cast<QVariantMap>(value.value<QDBusArgument>());
+            auto const output = config->output(map.value(QStringLiteral("id"), -1).toInt());
+            if (!output) {
+                qCWarning(DISMAN) << "Config delta changes unknown output.";
+                return false;
+            }
+
+            // Partial outputs never contain global data.
+            output_extras extras;
+            for (auto it = map.cbegin(); it != map.cend(); ++it) {
+                if (!deserialize_output_value(*output, extras, it.key(), it.value())) {
+                    return false;
+                }
+            }
+        }
+        outputsArg.endArray();
+    }
+
+    if (delta.contains(QLatin1String("primary-output"))) {
+        auto const id = delta[QStringLiteral("primary-output")].toInt();
+        auto output = config->output(id);
+        if (!output && id >= 0) {
+            return false;
+        }
+        config->set_primary_output(output);
+    }
+
+    if (delta.contains(QLatin1String("screen"))) {
+        const QDBusArgument& screenArg = delta[QStringLiteral("screen")].value<QDBusArgument>();
+        auto const screen = deserialize_screen(screenArg);
+        if (!screen) {
+            return false;
+        }
+        config->setScreen(screen);
+    }
+
+    return true;
+}
+
+namespace
+{
+
+// Version of the binary format. It only needs to be increased on incompatible changes. Adding
+// keys is compatible since unknown keys are ignored on deserialization.
+constexpr qint64 binary_format_version = 1;
+
+// Keys of the binary format. Existing values must never be changed or reused.
+enum binary_key : qint64 {
+    key_version = 0,
+    key_config = 1,
+
+    config_cause = 1,
+    config_features = 2,
+    config_primary_output = 3,
+    config_outputs = 4,
+    config_screen = 5,
+    config_tablet_mode_available = 6,
+    config_tablet_mode_engaged = 7,
+
+    output_id = 1,
+    output_name = 2,
+    output_description = 3,
+    output_hash = 4,
+    output_type = 5,
+    output_position = 6,
+    output_scale = 7,
+    output_rotation = 8,
+    output_resolution = 9,
+    output_refresh = 10,
+    output_preferred_modes = 11,
+    output_follow_preferred_mode = 12,
+    output_enabled = 13,
+    output_physical_size = 14,
+    output_replication_source = 15,
+    output_auto_rotate = 16,
+    output_auto_rotate_only_in_tablet_mode = 17,
+    output_auto_resolution = 18,
+    output_auto_refresh_rate = 19,
+    output_retention = 20,
+    output_adaptive_sync_toggle_support = 21,
+    output_adaptive_sync = 22,
+    output_modes = 23,
+    output_global = 24,
+
+    global_resolution = 1,
+    global_refresh = 2,
+    global_rotation = 3,
+    global_scale = 4,
+    global_auto_resolution = 5,
+    global_auto_refresh_rate = 6,
+    global_auto_rotate = 7,
+    global_auto_rotate_only_in_tablet_mode = 8,
+
+    mode_id = 1,
+    mode_name = 2,
+    mode_size = 3,
+    mode_refresh = 4,
+
+    screen_id = 1,
+    screen_current_size = 2,
+    screen_max_size = 3,
+    screen_min_size = 4,
+    screen_max_outputs_count = 5,
+};
+
+QCborArray binary_size(QSize const& size)
+{
+    return {size.width(), size.height()};
+}
+
+QSize binary_to_size(QCborValue const& value)
+{
+    auto const array = value.toArray();
+    return QSize(array.at(0).toInteger(), array.at(1).toInteger());
+}
+
+QCborArray binary_point(QPointF const& point)
+{
+    return {point.x(), point.y()};
+}
+
+QPointF binary_to_point(QCborValue const& value)
+{
+    auto const array = value.toArray();
+    return QPointF(array.at(0).toDouble(), array.at(1).toDouble());
+}
+
+QCborMap binary_mode(std::shared_ptr<Mode const> const& mode)
+{
+    QCborMap map;
+    map[mode_id] = QString::fromStdString(mode->id());
+    map[mode_name] = QString::fromStdString(mode->name());
+    map[mode_size] = binary_size(mode->size());
+    map[mode_refresh] = mode->refresh();
+    return map;
+}
+
+QCborMap binary_screen(ScreenPtr const& screen)
+{
+    QCborMap map;
+    map[screen_id] = screen->id();
+    map[screen_current_size] = binary_size(screen->current_size());
+    map[screen_max_size] = binary_size(screen->max_size());
+    map[screen_min_size] = binary_size(screen->min_size());
+    map[screen_max_outputs_count] = screen->max_outputs_count();
+    return map;
+}
+
+QCborMap binary_output(OutputPtr const& output)
+{
+    QCborMap map;
+
+    map[output_id] = output->id();
+    map[output_name] = QString::fromStdString(output->name());
+    map[output_description] = QString::fromStdString(output->description());
+    map[output_hash] = QString::fromStdString(output->hash());
+    map[output_type] = static_cast<int>(output->type());
+    map[output_position] = binary_point(output->position());
+    map[output_scale] = output->scale();
+    map[output_rotation] = static_cast<int>(output->rotation());
+
+    auto const mode = output->auto_mode();
+    assert(mode);
+    map[output_resolution] = binary_size(mode->size());
+    map[output_refresh] = mode->refresh();
+
+    QCborArray preferred_modes;
+    for (auto const& mode_string : output->preferred_modes()) {
+        preferred_modes.append(QString::fromStdString(mode_string));
+    }
+    map[output_preferred_modes] = preferred_modes;
+
+    map[output_follow_preferred_mode] = output->follow_preferred_mode();
+    map[output_enabled] = output->enabled();
+    map[output_physical_size] = binary_size(output->physical_size());
+    map[output_replication_source] = output->replication_source();
+    map[output_auto_rotate] = output->auto_rotate();
+    map[output_auto_rotate_only_in_tablet_mode] = output->auto_rotate_only_in_tablet_mode();
+    map[output_auto_resolution] = output->auto_resolution();
+    map[output_auto_refresh_rate] = output->auto_refresh_rate();
+    map[output_retention] = static_cast<int>(output->retention());
+    map[output_adaptive_sync_toggle_support] = output->adaptive_sync_toggle_support();
+    map[output_adaptive_sync] = output->adaptive_sync();
+
+    QCborArray modes;
+    for (auto const& [key, mode] : output->mode_map()) {
+        modes.append(binary_mode(mode));
+    }
+    map[output_modes] = modes;
+
+    auto const data = output->global_data();
+    if (data.valid) {
+        QCborMap global;
+        global[global_resolution] = binary_size(data.resolution);
+        global[global_refresh] = data.refresh;
+        global[global_rotation] = static_cast<int>(data.rotation);
+        global[global_scale] = data.scale;
+        global[global_auto_resolution] = data.auto_resolution;
+        global[global_auto_refresh_rate] = data.auto_refresh_rate;
+        global[global_auto_rotate] = data.auto_rotate;
+        global[global_auto_rotate_only_in_tablet_mode] = data.auto_rotate_only_in_tablet_mode;
+        map[output_global] = global;
+    }
+
+    return map;
+}
+
+ModePtr binary_to_mode(QCborMap const& map)
+{
+    ModePtr mode(new Mode);
+    mode->set_id(map.value(mode_id).toString().toStdString());
+    mode->set_name(map.value(mode_name).toString().toStdString());
+    mode->set_size(binary_to_size(map.value(mode_size)));
+    mode->set_refresh(map.value(mode_refresh).toInteger());
+    return mode;
+}
+
+ScreenPtr binary_to_screen(QCborMap const& map)
+{
+    ScreenPtr screen(new Screen);
+    screen->set_id(map.value(screen_id).toInteger());
+    screen->set_current_size(binary_to_size(map.value(screen_current_size)));
+    screen->set_max_size(binary_to_size(map.value(screen_max_size)));
+    screen->set_min_size(binary_to_size(map.value(screen_min_size)));
+    screen->set_max_outputs_count(map.value(screen_max_outputs_count).toInteger());
+    return screen;
+}
+
+OutputPtr binary_to_output(QCborMap const& map)
+{
+    if (!map.value(output_id).isInteger()) {
+        qCWarning(DISMAN) << "Binary output data without id.";
+        return OutputPtr();
+    }
+
+    OutputPtr output(new Output);
+
+    output->set_id(map.value(output_id).toInteger());
+    output->set_name(map.value(output_name).toString().toStdString());
+    output->set_description(map.value(output_description).toString().toStdString());
+    output->set_hash_raw(map.value(output_hash).toString().toStdString());
+    output->setType(static_cast<Output::Type>(map.value(output_type).toInteger()));
+    output->set_position(binary_to_point(map.value(output_position)));
+    output->set_scale(map.value(output_scale).toDouble(1.));
+    output->set_rotation(static_cast<Output::Rotation>(map.value(output_rotation).toInteger(1)));
+
+    ModeMap modes;
+    for (auto const& value : map.value(output_modes).toArray()) {
+        auto const mode = binary_to_mode(value.toMap());
+        modes.insert({mode->id(), mode});
+    }
+    output->set_modes(modes);
+
+    output->set_resolution(binary_to_size(map.value(output_resolution)));
+    output->set_refresh_rate(map.value(output_refresh).toInteger());
+
+    std::vector<std::string> preferred_modes;
+    for (auto const& value : map.value(output_preferred_modes).toArray()) {
+        preferred_modes.push_back(value.toString().toStdString());
+    }
+    output->set_preferred_modes(preferred_modes);
+
+    output->set_follow_preferred_mode(map.value(output_follow_preferred_mode).toBool());
+    output->set_enabled(map.value(output_enabled).toBool());
+    output->set_physical_size(binary_to_size(map.value(output_physical_size)));
+    output->set_replication_source(map.value(output_replication_source).toInteger());
+    output->set_auto_rotate(map.value(output_auto_rotate).toBool());
+    output->set_auto_rotate_only_in_tablet_mode(
+        map.value(output_auto_rotate_only_in_tablet_mode).toBool());
+    output->set_auto_resolution(map.value(output_auto_resolution).toBool(true));
+    output->set_auto_refresh_rate(map.value(output_auto_refresh_rate).toBool(true));
+    output->set_retention(
+        ConfigSerializer::deserialize_retention(map.value(output_retention).toInteger()));
+    output->set_adaptive_sync_toggle_support(
+        map.value(output_adaptive_sync_toggle_support).toBool());
+    output->set_adaptive_sync(map.value(output_adaptive_sync).toBool());
+
+    if (map.contains(output_global)) {
+        auto const global = map.value(output_global).toMap();
+        Output::GlobalData data;
+        data.resolution = binary_to_size(global.value(global_resolution));
+        data.refresh = global.value(global_refresh).toInteger();
+        data.rotation = static_cast<Output::Rotation>(global.value(global_rotation).toInteger());
+        data.scale = global.value(global_scale).toDouble();
+        data.auto_resolution = global.value(global_auto_resolution).toBool();
+        data.auto_refresh_rate = global.value(global_auto_refresh_rate).toBool();
+        data.auto_rotate = global.value(global_auto_rotate).toBool();
+        data.auto_rotate_only_in_tablet_mode
+            = global.value(global_auto_rotate_only_in_tablet_mode).toBool();
+        data.valid = true;
+        output->set_global_data(data);
+    }
+
+    return output;
+}
+
+}
+
+QByteArray ConfigSerializer::serialize_config_binary(ConfigPtr const& config)
+{
+    if (!config) {
+        return QByteArray();
+    }
+
+    QCborMap map;
+
+    map[config_cause] = static_cast<int>(config->cause());
+    map[config_features] = static_cast<int>(config->supported_features());
+    if (auto primary = config->primary_output()) {
+        map[config_primary_output] = primary->id();
+    }
+
+    QCborArray outputs;
+    for (auto const& [key, output] : config->output_map()) {
+        outputs.append(binary_output(output));
+    }
+    map[config_outputs] = outputs;
+
+    if (config->screen()) {
+        map[config_screen] = binary_screen(config->screen());
+    }
+
+    map[config_tablet_mode_available] = config->tablet_mode_available();
+    map[config_tablet_mode_engaged] = config->tablet_mode_engaged();
+
+    QCborMap top;
+    top[key_version] = binary_format_version;
+    top[key_config] = map;
+    return top.toCborValue().toCbor();
+}
+
+ConfigPtr ConfigSerializer::deserialize_config_binary(QByteArray const& data)
+{
+    QCborParserError error;
+    auto const top = QCborValue::fromCbor(data, &error).toMap();
+    if (error.error != QCborError::NoError) {
+        qCWarning(DISMAN) << "Failed to parse binary config:" << error.errorString();
+        return ConfigPtr();
+    }
+
+    auto const version = top.value(key_version).toInteger(-1);
+    if (version != binary_format_version) {
+        qCWarning(DISMAN) << "Unsupported binary config version:" << version;
+        return ConfigPtr();
+    }
+
+    auto const map = top.value(key_config).toMap();
+
+    ConfigPtr config(new Config(deserialize_cause(map.value(config_cause).toInteger())));
+    config->set_supported_features(
+        static_cast<Config::Features>(map.value(config_features).toInteger()));
+    config->set_tablet_mode_available(map.value(config_tablet_mode_available).toBool());
+    config->set_tablet_mode_engaged(map.value(config_tablet_mode_engaged).toBool());
+
+    OutputMap outputs;
+    for (auto const& value : map.value(config_outputs).toArray()) {
+        auto const output = binary_to_output(value.toMap());
+        if (!output) {
+            return ConfigPtr();
+        }
+        outputs.insert({output->id(), output});
+    }
+    config->set_outputs(outputs);
+
+    if (map.contains(config_primary_output)) {
+        auto output = config->output(map.value(config_primary_output).toInteger());
+        if (!output) {
+            return ConfigPtr();
+        }
+        config->set_primary_output(output);
+    }
+
+    if (map.contains(config_screen)) {
+        config->setScreen(binary_to_screen(map.value(config_screen).toMap()));
+    }
+
+    return config;
+}
+
+namespace
+{
+
+template<typename T>
+void write_entry(QDBusArgument& arg, QString const& key, T const& value)
+{
+    arg.beginMapEntry();
+    arg << key << QDBusVariant(QVariant::fromValue(value));
+    arg.endMapEntry();
+}
+
+ConfigSerializer::DBusSize dbus_size(QSize const& size)
+{
+    return {size};
+}
+
+ConfigSerializer::DBusPoint dbus_point(QPointF const& point)
+{
+    return {point};
+}
+
+void begin_dbus_map(QDBusArgument& arg)
+{
+    arg.beginMap(QMetaType::fromType<QString>(), QMetaType::fromType<QDBusVariant>());
+}
+
+}
+
+void ConfigSerializer::register_dbus_types()
+{
+    qDBusRegisterMetaType<DBusConfig>();
+    qDBusRegisterMetaType<DBusCompactConfig>();
+    qDBusRegisterMetaType<DBusOutput>();
+    qDBusRegisterMetaType<DBusMode>();
+    qDBusRegisterMetaType<DBusScreen>();
+    qDBusRegisterMetaType<DBusSize>();
+    qDBusRegisterMetaType<DBusPoint>();
+}
+
+namespace
+{
+
+void write_dbus_config(QDBusArgument& arg,
+                       ConfigPtr const& cfg,
+                       std::set<uint64_t> const* known_mode_tables)
+{
+    begin_dbus_map(arg);
+
+    if (cfg) {
+        write_entry(arg, QStringLiteral("cause"), static_cast<int>(cfg->cause()));
+        write_entry(arg, QStringLiteral("features"), static_cast<int>(cfg->supported_features()));
+        if (auto primary = cfg->primary_output()) {
+            write_entry(arg, QStringLiteral("primary-output"), primary->id());
+        }
+
+        QVariantList outputs;
+        for (auto const& [key, output] : cfg->output_map()) {
+            DBusOutput dbus_output{output};
+            if (known_mode_tables) {
+                dbus_output.with_fingerprint = true;
+                dbus_output.omit_modes = known_mode_tables->count(output->modes_fingerprint()) > 0;
+            }
+            outputs.push_back(QVariant::fromValue(dbus_output));
+        }
+        write_entry(arg, QStringLiteral("outputs"), outputs);
+
+        if (cfg->screen()) {
+            write_entry(arg, QStringLiteral("screen"), DBusScreen{cfg->screen()});
+        }
+
+        write_entry(arg, QStringLiteral("tablet_mode_available"), cfg->tablet_mode_available());
+        write_entry(arg, QStringLiteral("tablet_mode_engaged"), cfg->tablet_mode_engaged());
+    }
+
+    arg.endMap();
+}
+
+}
+
+QDBusArgument& ConfigSerializer::operator<<(QDBusArgument& arg, DBusConfig const& config)
+{
+    write_dbus_config(arg, config.config, nullptr);
+    return arg;
+}
+
+QDBusArgument& ConfigSerializer::operator<<(QDBusArgument& arg, DBusCompactConfig const& config)
+{
+    write_dbus_config(arg, config.config, &config.known_mode_tables);
+    return arg;
+}
+
+QDBusArgument& ConfigSerializer::operator<<(QDBusArgument& arg, DBusOutput const& output)
+{
+    begin_dbus_map(arg);
+
+    if (auto const& out = output.output) {
+        write_entry(arg, QStringLiteral("id"), out->id());
+        write_entry(arg, QStringLiteral("name"), QString::fromStdString(out->name()));
+        write_entry(
+            arg, QStringLiteral("description"), QString::fromStdString(out->description()));
+        write_entry(arg, QStringLiteral("hash"), QString::fromStdString(out->hash()));
+        write_entry(arg, QStringLiteral("type"), static_cast<int>(out->type()));
+        write_entry(arg, QStringLiteral("position"), dbus_point(out->position()));
+        write_entry(arg, QStringLiteral("scale"), out->scale());
+        write_entry(arg, QStringLiteral("rotation"), static_cast<int>(out->rotation()));
+
+        auto const mode = out->auto_mode();
+        assert(mode);
+        write_entry(arg, QStringLiteral("resolution"), dbus_size(mode->size()));
+        write_entry(arg, QStringLiteral("refresh"), mode->refresh());
+
+        QVariantList preferred_modes;
+        for (auto const& mode_string : out->preferred_modes()) {
+            preferred_modes.push_back(QString::fromStdString(mode_string));
+        }
+        write_entry(arg, QStringLiteral("preferred_modes"), preferred_modes);
+
+        write_entry(arg, QStringLiteral("follow_preferred_mode"), out->follow_preferred_mode());
+        write_entry(arg, QStringLiteral("enabled"), out->enabled());
+        write_entry(arg, QStringLiteral("physical_size"), dbus_size(out->physical_size()));
+        write_entry(arg, QStringLiteral("replication_source"), out->replication_source());
+        write_entry(arg, QStringLiteral("auto_rotate"), out->auto_rotate());
+        write_entry(arg,
+                    QStringLiteral("auto_rotate_only_in_tablet_mode"),
+                    out->auto_rotate_only_in_tablet_mode());
+        write_entry(arg, QStringLiteral("auto_resolution"), out->auto_resolution());
+        write_entry(arg, QStringLiteral("auto_refresh_rate"), out->auto_refresh_rate());
+        write_entry(arg, QStringLiteral("retention"), static_cast<int>(out->retention()));
+        write_entry(arg,
+                    QStringLiteral("adaptive_sync_toggle_support"),
+                    out->adaptive_sync_toggle_support());
+        write_entry(arg, QStringLiteral("adaptive_sync"), out->adaptive_sync());
+
+        if (output.with_fingerprint) {
+            write_entry(arg,
+                        QStringLiteral("modes_fingerprint"),
+                        static_cast<qulonglong>(out->modes_fingerprint()));
+        }
+        if (!output.omit_modes) {
+            QVariantList modes;
+            for (auto const& [key, mode] : out->mode_map()) {
+                modes.push_back(QVariant::fromValue(DBusMode{mode}));
+            }
+            write_entry(arg, QStringLiteral("modes"), modes);
+        }
+
+        auto const data = out->global_data();
+        if (data.valid) {
+            write_entry(arg, QStringLiteral("global"), true);
+            write_entry(arg, QStringLiteral("global.resolution"), dbus_size(data.resolution));
+            write_entry(arg, QStringLiteral("global.refresh"), data.refresh);
+            write_entry(arg, QStringLiteral("global.rotation"), static_cast<int>(data.rotation));
+            write_entry(arg, QStringLiteral("global.scale"), data.scale);
+            write_entry(arg, QStringLiteral("global.auto_resolution"), data.auto_resolution);
+            write_entry(arg, QStringLiteral("global.auto_refresh_rate"), data.auto_refresh_rate);
+            write_entry(arg, QStringLiteral("global.auto_rotate"), data.auto_rotate);
+            write_entry(arg,
+                        QStringLiteral("global.auto_rotate_only_in_tablet_mode"),
+                        data.auto_rotate_only_in_tablet_mode);
+        }
+    }
+
+    arg.endMap();
+    return arg;
+}
+
+QDBusArgument& ConfigSerializer::operator<<(QDBusArgument& arg, DBusMode const& mode)
+{
+    begin_dbus_map(arg);
+
+    if (auto const& md = mode.mode) {
+        write_entry(arg, QStringLiteral("id"), QString::fromStdString(md->id()));
+        write_entry(arg, QStringLiteral("name"), QString::fromStdString(md->name()));
+        write_entry(arg, QStringLiteral("size"), dbus_size(md->size()));
+        write_entry(arg, QStringLiteral("refresh"), md->refresh());
+    }
+
+    arg.endMap();
+    return arg;
+}
+
+QDBusArgument& ConfigSerializer::operator<<(QDBusArgument& arg, DBusSize const& size)
+{
+    begin_dbus_map(arg);
+    write_entry(arg, QStringLiteral("width"), size.size.width());
+    write_entry(arg, QStringLiteral("height"), size.size.height());
+    arg.endMap();
+    return arg;
+}
+
+QDBusArgument& ConfigSerializer::operator<<(QDBusArgument& arg, DBusPoint const& point)
+{
+    begin_dbus_map(arg);
+    write_entry(arg, QStringLiteral("x"), point.point.x());
+    write_entry(arg, QStringLiteral("y"), point.point.y());
+    arg.endMap();
+    return arg;
+}
+
+QDBusArgument& ConfigSerializer::operator<<(QDBusArgument& arg, DBusScreen const& screen)
+{
+    begin_dbus_map(arg);
+
+    if (auto const& scr = screen.screen) {
+        write_entry(arg, QStringLiteral("id"), scr->id());
+        write_entry(arg, QStringLiteral("current_size"), dbus_size(scr->current_size()));
+        write_entry(arg, QStringLiteral("max_size"), dbus_size(scr->max_size()));
+        write_entry(arg, QStringLiteral("min_size"), dbus_size(scr->min_size()));
+        write_entry(arg, QStringLiteral("max_outputs_count"), scr->max_outputs_count());
+    }
+
+    arg.endMap();
+    return arg;
+}
+
+namespace
+{
+
+ConfigPtr read_dbus_config(QDBusArgument const& arg, std::map<int, uint64_t>& omitted_mode_tables)
+{
+    omitted_mode_tables.clear();
+
+    ConfigPtr result(new Config);
+    OutputMap outputs;
+    auto primary_id = -1;
+    auto valid = true;
+
+    arg.beginMap();
+    while (!arg.atEnd()) {
+        QString key;
+        QVariant value;
+        arg.beginMapEntry();
+        arg >> key >> value;
+
+        if (key == QLatin1String("cause")) {
+            result->set_cause(deserialize_cause(value));
+        } else if (key == QLatin1String("features")) {
+            result->set_supported_features(static_cast<Config::Features>(value.toInt()));
+        } else if (key == QLatin1String("tablet_mode_available")) {
+            result->set_tablet_mode_available(value.toBool());
+        } else if (key == QLatin1String("tablet_mode_engaged")) {
+            result->set_tablet_mode_engaged(value.toBool());
+        } else if (key == QLatin1String("primary-output")) {
+            primary_id = value.toInt();
+        } else if (key == QLatin1String("outputs")) {
+            auto const outputs_arg = value.value<QDBusArgument>();
+            outputs_arg.beginArray();
+            while (!outputs_arg.atEnd()) {
+                QVariant output_value;
+                outputs_arg >> output_value;
+                output_extras extras;
+                auto const output
+                    = deserialize_output_map(output_value.value<QDBusArgument>(), extras);
+                if (!output) {
+                    valid = false;
+                    continue;
+                }
+                if (!extras.has_modes && extras.modes_fingerprint) {
+                    omitted_mode_tables.insert({output->id(), extras.modes_fingerprint});
+                }
+                outputs.insert({output->id(), output});
+            }
+            outputs_arg.endArray();
+        } else if (key == QLatin1String("screen")) {
+            auto const screen = deserialize_screen(value.value<QDBusArgument>());
+            if (screen) {
+                result->setScreen(screen);
+            } else {
+                valid = false;
+            }
+        }
+
+        arg.endMapEntry();
+    }
+    arg.endMap();
+
+    result->set_outputs(outputs);
+    if (primary_id >= 0) {
+        auto primary = result->output(primary_id);
+        if (!primary) {
+            valid = false;
+        }
+        result->set_primary_output(primary);
+    }
+
+    return valid ? result : ConfigPtr();
+}
+
+}
+
+QDBusArgument const& ConfigSerializer::operator>>(QDBusArgument const& arg, DBusConfig& config)
+{
+    // Configs in the legacy layout never omit mode lists.
+    std::map<int, uint64_t> omitted_mode_tables;
+    config.config = read_dbus_config(arg, omitted_mode_tables);
+    return arg;
+}
+
+QDBusArgument const& ConfigSerializer::operator>>(QDBusArgument const& arg,
+                                                  DBusCompactConfig& config)
+{
+    config.config = read_dbus_config(arg, config.omitted_mode_tables);
+    return arg;
+}
+
+QDBusArgument const& ConfigSerializer::operator>>(QDBusArgument const& arg, DBusOutput& output)
+{
+    output.output = deserialize_output(arg);
+    return arg;
+}
+
+QDBusArgument const& ConfigSerializer::operator>>(QDBusArgument const& arg, DBusMode& mode)
+{
+    mode.mode = deserialize_mode(arg);
+    return arg;
+}
+
+QDBusArgument const& ConfigSerializer::operator>>(QDBusArgument const& arg, DBusScreen& screen)
+{
+    screen.screen = deserialize_screen(arg);
+    return arg;
+}
+
+QDBusArgument const& ConfigSerializer::operator>>(QDBusArgument const& arg, DBusSize& size)
+{
+    size.size = deserialize_size(arg);
+    return arg;
+}
+
+QDBusArgument const& ConfigSerializer::operator>>(QDBusArgument const& arg, DBusPoint& point)
+{
+    point.point = deserialize_point(arg);
+    return arg;
+}
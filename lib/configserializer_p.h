@@ -25,6 +25,11 @@
 #include <QJsonObject>
 #include <QVariant>
 
+#include <cstdint>
+#include <map>
+#include <set>
+
+#include "configdiff.h"
 #include "disman_export.h"
 #include "output.h"
 #include "types.h"
@@ -50,9 +55,17 @@ DISMAN_EXPORT QJsonArray serialize_list(const QList<T>& list)
 
 DISMAN_EXPORT QJsonObject serialize_config(const Disman::ConfigPtr& config);
 DISMAN_EXPORT QJsonObject serialize_output(const Disman::OutputPtr& output);
-DISMAN_EXPORT QJsonObject serialize_mode(const Disman::ModePtr& mode);
+DISMAN_EXPORT QJsonObject serialize_mode(std::shared_ptr<Disman::Mode const> const& mode);
 DISMAN_EXPORT QJsonObject serialize_screen(const Disman::ScreenPtr& screen);
 
+/**
+ * Serializes only what @p diff lists as changed in @p config. Added outputs and outputs with
+ * changed global data are contained in full in "outputs", other changed outputs only with their
+ * id and changed values in "changed_outputs". Ids of removed outputs are in "removed_outputs".
+ */
+DISMAN_EXPORT QJsonObject serialize_config_delta(Disman::ConfigPtr const& config,
+                                                 Disman::ConfigDiff const& diff);
+
 DISMAN_EXPORT QPointF deserialize_point(const QDBusArgument& map);
 DISMAN_EXPORT QSize deserialize_size(const QDBusArgument& map);
 DISMAN_EXPORT QSizeF deserialize_sizef(const QDBusArgument& map);
@@ -75,8 +88,116 @@ DISMAN_EXPORT Disman::ModePtr deserialize_mode(const QDBusArgument& mode);
 DISMAN_EXPORT Disman::ScreenPtr deserialize_screen(const QDBusArgument& screen);
 DISMAN_EXPORT Disman::Output::Retention deserialize_retention(QVariant const& var);
 
+/**
+ * Applies a delta created with serialize_config_delta to @p config.
+ *
+ * @return false if the delta could not be applied, @p config may be partially updated then
+ */
+DISMAN_EXPORT bool apply_config_delta(Disman::ConfigPtr const& config, QVariantMap const& delta);
+
+/**
+ * Serializes @p config to the compact binary format exchanged by the getConfigBinary and
+ * setConfigBinary DBus methods. The format is CBOR with fixed integer keys and a version header.
+ */
+DISMAN_EXPORT QByteArray serialize_config_binary(Disman::ConfigPtr const& config);
+
+/**
+ * Deserializes a config created with serialize_config_binary. Unknown keys are ignored.
+ *
+ * @return the config or null if @p data is malformed or has an unsupported version
+ */
+DISMAN_EXPORT Disman::ConfigPtr deserialize_config_binary(QByteArray const& data);
+
+/**
+ * Wrappers to marshall configs and their parts directly from and to DBus arguments without
+ * intermediate JSON objects and variant maps. The resulting maps have the same layout as the
+ * maps created from serialize_config, so both can be read with either deserializer.
+ *
+ * The types must be registered with register_dbus_types before being used with QtDBus.
+ */
+struct DBusConfig {
+    Disman::ConfigPtr config;
+};
+
+/**
+ * Version of the compact config layout clients subscribe to for configChangedCompact.
+ */
+constexpr uint32_t compact_config_version{1};
+
+/**
+ * Change signals a client receives after subscribing to them with subscribeConfigChanges. Clients
+ * that never subscribed receive the legacy configChanged signal instead.
+ */
+enum ConfigChannel : uint32_t {
+    compact_channel = 1 << 0,
+    delta_channel = 1 << 1,
+};
+
+/**
+ * Config in the compact layout. Outputs additionally carry the fingerprint of their mode table
+ * and their mode lists are omitted if the receiver knows them already. Only sent to clients that
+ * subscribed to it, so clients reading the legacy layout are not affected.
+ */
+struct DBusCompactConfig {
+    Disman::ConfigPtr config;
+
+    // When writing, the mode lists of outputs with these fingerprints are omitted.
+    std::set<uint64_t> known_mode_tables;
+
+    // After reading, the ids of outputs whose mode lists were omitted with their fingerprints.
+    std::map<int, uint64_t> omitted_mode_tables;
+};
+struct DBusOutput {
+    Disman::OutputPtr output;
+
+    // Only in the compact layout.
+    bool with_fingerprint{false};
+    bool omit_modes{false};
+};
+struct DBusMode {
+    std::shared_ptr<Disman::Mode const> mode;
+};
+struct DBusScreen {
+    Disman::ScreenPtr screen;
+};
+
+// Streamed as maps of their components without building a QVariantMap first.
+struct DBusSize {
+    QSize size;
+};
+struct DBusPoint {
+    QPointF point;
+};
+
+DISMAN_EXPORT void register_dbus_types();
+
+DISMAN_EXPORT QDBusArgument& operator<<(QDBusArgument& arg, DBusConfig const& config);
+DISMAN_EXPORT QDBusArgument& operator<<(QDBusArgument& arg, DBusCompactConfig const& config);
+DISMAN_EXPORT QDBusArgument& operator<<(QDBusArgument& arg, DBusOutput const& output);
+DISMAN_EXPORT QDBusArgument& operator<<(QDBusArgument& arg, DBusMode const& mode);
+DISMAN_EXPORT QDBusArgument& operator<<(QDBusArgument& arg, DBusScreen const& screen);
+DISMAN_EXPORT QDBusArgument& operator<<(QDBusArgument& arg, DBusSize const& size);
+DISMAN_EXPORT QDBusArgument& operator<<(QDBusArgument& arg, DBusPoint const& point);
+
+DISMAN_EXPORT QDBusArgument const& operator>>(QDBusArgument const& arg, DBusConfig& config);
+DISMAN_EXPORT QDBusArgument const& operator>>(QDBusArgument const& arg,
+                                              DBusCompactConfig& config);
+DISMAN_EXPORT QDBusArgument const& operator>>(QDBusArgument const& arg, DBusOutput& output);
+DISMAN_EXPORT QDBusArgument const& operator>>(QDBusArgument const& arg, DBusMode& mode);
+DISMAN_EXPORT QDBusArgument const& operator>>(QDBusArgument const& arg, DBusScreen& screen);
+DISMAN_EXPORT QDBusArgument const& operator>>(QDBusArgument const& arg, DBusSize& size);
+DISMAN_EXPORT QDBusArgument const& operator>>(QDBusArgument const& arg, DBusPoint& point);
+
 }
 
 }
 
+Q_DECLARE_METATYPE(Disman::ConfigSerializer::DBusConfig)
+Q_DECLARE_METATYPE(Disman::ConfigSerializer::DBusCompactConfig)
+Q_DECLARE_METATYPE(Disman::ConfigSerializer::DBusOutput)
+Q_DECLARE_METATYPE(Disman::ConfigSerializer::DBusMode)
+Q_DECLARE_METATYPE(Disman::ConfigSerializer::DBusScreen)
+Q_DECLARE_METATYPE(Disman::ConfigSerializer::DBusSize)
+Q_DECLARE_METATYPE(Disman::ConfigSerializer::DBusPoint)
+
 #endif
@@ -0,0 +1,340 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "configsnapshot_p.h"
+
+#include "config.h"
+#include "configserializer_p.h"
+#include "disman_debug.h"
+
+#include <QByteArray>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Disman
+{
+
+namespace
+{
+
+constexpr uint32_t snapshot_magic = 0x444d4353; // "DMCS"
+constexpr uint32_t snapshot_version = 2;
+
+// Leaves room for growing configs before the region must be replaced.
+constexpr size_t min_payload_capacity = 64 * 1024;
+
+// A writer only holds the sequence odd for a memcpy. Only retry a few times in case the region
+// is updated in a tight loop.
+constexpr int max_read_attempts = 16;
+
+struct snapshot_header {
+    uint32_t magic;
+    uint32_t version;
+
+    // Odd while the payload is written.
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> generation;
+    std::atomic<uint64_t> size;
+
+    // Set when the writer replaced the region.
+    std::atomic<uint32_t> retired;
+
+    // Set while a change of the config has not been published yet.
+    std::atomic<uint32_t> pending;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory requires lock-free 64-bit atomics.");
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "Shared memory requires lock-free 32-bit atomics.");
+
+}
+
+ConfigSnapshotWriter::ConfigSnapshotWriter() = default;
+
+ConfigSnapshotWriter::~ConfigSnapshotWriter()
+{
+    release();
+}
+
+int ConfigSnapshotWriter::fd() const
+{
+    return m_fd;
+}
+
+bool ConfigSnapshotWriter::publish(ConfigPtr const& config, uint64_t generation)
+{
+    if (!config) {
+        return false;
+    }
+
+    auto const payload = ConfigSerializer::serialize_config_binary(config);
+    auto const payload_size = static_cast<size_t>(payload.size());
+
+    if (!m_data || sizeof(snapshot_header) + payload_size > m_capacity) {
+        if (!allocate(payload_size)) {
+            // Readers must not keep reading the old config.
+            release();
+            return false;
+        }
+    }
+
+    auto header = static_cast<snapshot_header*>(m_data);
+    auto const sequence = header->sequence.load(std::memory_order_relaxed);
+
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(static_cast<char*>(m_data) + sizeof(snapshot_header),
+                payload.constData(),
+                payload_size);
+    header->generation.store(generation, std::memory_order_relaxed);
+    header->size.store(payload_size, std::memory_order_relaxed);
+
+    header->sequence.store(sequence + 2, std::memory_order_release);
+    header->pending.store(0, std::memory_order_release);
+    return true;
+}
+
+void ConfigSnapshotWriter::set_pending(bool pending)
+{
+    if (!m_data) {
+        return;
+    }
+    static_cast<snapshot_header*>(m_data)->pending.store(pending ? 1 : 0,
+                                                         std::memory_order_release);
+}
+
+bool ConfigSnapshotWriter::allocate(size_t payload_size)
+{
+#ifdef Q_OS_LINUX
+    auto const page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto const capacity
+        = sizeof(snapshot_header) + std::max(min_payload_capacity, 2 * payload_size);
+    auto const size = (capacity + page_size - 1) / page_size * page_size;
+
+    auto fd = memfd_create("disman-config", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        qCWarning(DISMAN) << "Failed to create shared config region:" << strerror(errno);
+        return false;
+    }
+
+    // Readers rely on the size never changing, otherwise they could fault on access.
+    if (ftruncate(fd, static_cast<off_t>(size)) < 0
+        || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+        qCWarning(DISMAN) << "Failed to prepare shared config region:" << strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        qCWarning(DISMAN) << "Failed to map shared config region:" << strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    // Hand out a read-only descriptor, so readers can not modify the region.
+    auto const fd_path = QByteArray("/proc/self/fd/") + QByteArray::number(fd);
+    auto read_fd = open(fd_path.constData(), O_RDONLY | O_CLOEXEC);
+    if (read_fd >= 0) {
+        close(fd);
+        fd = read_fd;
+    }
+
+    release();
+
+    auto header = new (data) snapshot_header;
+    header->magic = snapshot_magic;
+    header->version = snapshot_version;
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->generation.store(0, std::memory_order_relaxed);
+    header->size.store(0, std::memory_order_relaxed);
+    header->retired.store(0, std::memory_order_relaxed);
+    header->pending.store(0, std::memory_order_relaxed);
+
+    m_fd = fd;
+    m_data = data;
+    m_capacity = size;
+    return true;
+#else
+    Q_UNUSED(payload_size)
+    return false;
+#endif
+}
+
+void ConfigSnapshotWriter::release()
+{
+#ifdef Q_OS_LINUX
+    if (m_data) {
+        static_cast<snapshot_header*>(m_data)->retired.store(1, std::memory_order_release);
+        munmap(m_data, m_capacity);
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+
+    m_fd = -1;
+    m_data = nullptr;
+    m_capacity = 0;
+}
+
+ConfigSnapshotReader::~ConfigSnapshotReader()
+{
+    unmap();
+}
+
+bool ConfigSnapshotReader::map(int fd)
+{
+    unmap();
+
+#ifdef Q_OS_LINUX
+    auto const seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || !(seals & F_SEAL_SHRINK)) {
+        qCWarning(DISMAN) << "Shared config region is not sealed.";
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || info.st_size < static_cast<off_t>(sizeof(snapshot_header))) {
+        qCWarning(DISMAN) << "Shared config region has an invalid size.";
+        return false;
+    }
+
+    auto const size = static_cast<size_t>(info.st_size);
+    auto data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        qCWarning(DISMAN) << "Failed to map shared config region:" << strerror(errno);
+        return false;
+    }
+
+    auto header = static_cast<snapshot_header const*>(data);
+    if (header->magic != snapshot_magic || header->version != snapshot_version) {
+        qCWarning(DISMAN) << "Shared config region has an unsupported layout.";
+        munmap(data, size);
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    return true;
+#else
+    Q_UNUSED(fd)
+    return false;
+#endif
+}
+
+bool ConfigSnapshotReader::mapped() const
+{
+    return m_data != nullptr;
+}
+
+bool ConfigSnapshotReader::retired() const
+{
+    if (!m_data) {
+        return false;
+    }
+    return static_cast<snapshot_header const*>(m_data)->retired.load(std::memory_order_acquire);
+}
+
+ConfigPtr ConfigSnapshotReader::read(uint64_t& generation) const
+{
+    if (!m_data) {
+        return ConfigPtr();
+    }
+
+    auto header = static_cast<snapshot_header const*>(m_data);
+    auto const payload = static_cast<char const*>(m_data) + sizeof(snapshot_header);
+    auto const capacity = m_size - sizeof(snapshot_header);
+
+    for (int attempt = 0; attempt < max_read_attempts; attempt++) {
+        auto const sequence = header->sequence.load(std::memory_order_acquire);
+        if (sequence == 0) {
+            // Nothing published yet.
+            return ConfigPtr();
+        }
+        if (sequence % 2) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        auto const read_generation = header->generation.load(std::memory_order_relaxed);
+        auto const size = header->size.load(std::memory_order_relaxed);
+
+        // The payload is parsed right from the mapped memory. The result is only trusted when
+        // the sequence did not change meanwhile.
+        ConfigPtr config;
+        if (size <= capacity) {
+            config = ConfigSerializer::deserialize_config_binary(
+                QByteArray::fromRawData(payload, static_cast<qsizetype>(size)));
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        if (!config) {
+            qCWarning(DISMAN) << "Failed to read config from shared region.";
+            return ConfigPtr();
+        }
+
+        generation = read_generation;
+        return config;
+    }
+
+    qCDebug(DISMAN) << "Shared config region changed while reading it. Giving up.";
+    return ConfigPtr();
+}
+
+bool ConfigSnapshotReader::current_generation(uint64_t& generation) const
+{
+    if (!m_data || retired()) {
+        return false;
+    }
+
+    auto header = static_cast<snapshot_header const*>(m_data);
+    auto const sequence = header->sequence.load(std::memory_order_acquire);
+    if (sequence == 0 || sequence % 2 || header->pending.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    auto const read_generation = header->generation.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->sequence.load(std::memory_order_relaxed) != sequence) {
+        return false;
+    }
+
+    generation = read_generation;
+    return true;
+}
+
+void ConfigSnapshotReader::unmap()
+{
+#ifdef Q_OS_LINUX
+    if (m_data) {
+        munmap(const_cast<void*>(m_data), m_size);
+    }
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+}
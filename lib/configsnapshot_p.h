@@ -0,0 +1,116 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "disman_export.h"
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Disman
+{
+
+/**
+ * Publishes the current config in a shared memory region for other processes to read.
+ *
+ * The region is backed by a sealed memfd. It starts with a header holding a sequence number, the
+ * generation of the config and the size of the payload, followed by the config in the binary
+ * format of ConfigSerializer::serialize_config_binary. The sequence number is odd while the
+ * region is written to. Readers retry when it was odd or changed while they read.
+ *
+ * The header also marks when the config changed but the change has not been published yet. That
+ * way readers can tell if the published config is current without waiting for a signal.
+ *
+ * The region never shrinks. When a config does not fit anymore, a new region is created and the
+ * old one is marked as retired, such that readers know to request the new one. The region is
+ * retired as well when publishing fails.
+ *
+ * Only available on Linux. Elsewhere publishing always fails.
+ */
+class DISMAN_EXPORT ConfigSnapshotWriter
+{
+public:
+    ConfigSnapshotWriter();
+    ~ConfigSnapshotWriter();
+
+    ConfigSnapshotWriter(ConfigSnapshotWriter const&) = delete;
+    ConfigSnapshotWriter& operator=(ConfigSnapshotWriter const&) = delete;
+
+    bool publish(ConfigPtr const& config, uint64_t generation);
+
+    /**
+     * Marks that the published config is about to be replaced, or with @p pending false that it
+     * stays current after all. Publishing a config clears the mark.
+     */
+    void set_pending(bool pending);
+
+    /**
+     * The file descriptor of the current region or -1 if nothing was published yet. Ownership
+     * stays with the writer.
+     */
+    int fd() const;
+
+private:
+    bool allocate(size_t payload_size);
+    void release();
+
+    int m_fd{-1};
+    void* m_data{nullptr};
+    size_t m_capacity{0};
+};
+
+/**
+ * Maps a region created by ConfigSnapshotWriter read-only and reads configs from it.
+ */
+class DISMAN_EXPORT ConfigSnapshotReader
+{
+public:
+    ConfigSnapshotReader() = default;
+    ~ConfigSnapshotReader();
+
+    ConfigSnapshotReader(ConfigSnapshotReader const&) = delete;
+    ConfigSnapshotReader& operator=(ConfigSnapshotReader const&) = delete;
+
+    /**
+     * Maps the region behind @p fd. The descriptor is not needed anymore afterwards.
+     *
+     * @return false if @p fd does not refer to a sealed region with a supported layout
+     */
+    bool map(int fd);
+    void unmap();
+    bool mapped() const;
+
+    /**
+     * Whether the writer abandoned the region. Further reads only return stale configs.
+     */
+    bool retired() const;
+
+    /**
+     * Reads the published config. The payload is deserialized in place from the mapped memory
+     * and only accepted when no write happened in the meantime.
+     *
+     * @param generation set to the generation of the returned config
+     * @return the config or null if the region is not mapped or no consistent config could be
+     * read
+     */
+    ConfigPtr read(uint64_t& generation) const;
+
+    /**
+     * Gets the generation of the published config without reading it.
+     *
+     * @param generation set to the generation of the published config
+     * @return false if nothing is known to be current: the region is not mapped or retired,
+     * nothing was published yet or a change is pending
+     */
+    bool current_generation(uint64_t& generation) const;
+
+private:
+    void const* m_data{nullptr};
+    size_t m_size{0};
+};
+
+}
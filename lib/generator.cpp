@@ -35,7 +35,7 @@ Generator::Generator(ConfigPtr const& config)
 
 void Generator::prepare_config()
 {
-    for (auto const& [key, output] : m_config->outputs()) {
+    for (auto const& [key, output] : m_config->output_map()) {
         if (output->d->global.valid) {
             // We have global data for the output. We fall back to these values if necessary.
             continue;
@@ -86,7 +86,7 @@ void normalize_positions(ConfigPtr& config)
     double min_y = 0;
     bool is_set = false;
 
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         if (!output->positionable()) {
             continue;
         }
@@ -107,7 +107,7 @@ void normalize_positions(ConfigPtr& config)
         }
     }
 
-    for (auto& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         auto const pos = output->position();
         output->set_position(QPointF(pos.x() - min_x, pos.y() - min_y));
     }
@@ -159,13 +159,13 @@ bool Generator::disable_embedded()
     assert(m_config);
     auto config = m_config->clone();
 
-    auto embedded = embedded_impl(config->outputs(), OutputMap());
+    auto embedded = embedded_impl(config->output_map(), OutputMap());
     if (!embedded) {
         qCWarning(DISMAN) << "No embedded output found to disable. Config unchanged.";
         return false;
     }
 
-    auto biggest_external = biggest_impl(config->outputs(), false, {{embedded->id(), embedded}});
+    auto biggest_external = biggest_impl(config->output_map(), false, {{embedded->id(), embedded}});
     if (!biggest_external) {
         qCWarning(DISMAN) << "No external output found when disabling embedded. Config unchanged.";
         return false;
@@ -191,15 +191,15 @@ bool Generator::disable_embedded()
 
 ConfigPtr Generator::optimize_impl()
 {
-    qCDebug(DISMAN) << "Generates ideal config for" << m_config->outputs().size() << "displays.";
+    qCDebug(DISMAN) << "Generates ideal config for" << m_config->output_map().size() << "displays.";
 
-    if (m_config->outputs().empty()) {
+    if (m_config->output_map().empty()) {
         qCDebug(DISMAN) << "No displays connected. Nothing to generate.";
         return m_config;
     }
 
     auto config = m_config->clone();
-    auto outputs = config->outputs();
+    auto const& outputs = config->output_map();
 
     if (outputs.size() == 1) {
         single_output(config);
@@ -244,14 +244,14 @@ double Generator::best_scale(OutputPtr const& output)
 
 void Generator::single_output(ConfigPtr const& config)
 {
-    auto outputs = config->outputs();
+    auto const& outputs = config->output_map();
 
     if (outputs.empty()) {
         return;
     }
 
     auto output = outputs.begin()->second;
-    if (output->modes().empty()) {
+    if (output->mode_map().empty()) {
         return;
     }
 
@@ -270,7 +270,7 @@ void Generator::extend_impl(ConfigPtr const& config,
 {
     assert(!first || first->enabled());
 
-    auto outputs = config->outputs();
+    auto const& outputs = config->output_map();
 
     qCDebug(DISMAN) << "Generate config by extending to the"
                     << (direction == Extend_direction::left ? "left" : "right");
@@ -310,7 +310,7 @@ void Generator::get_outputs_division(OutputPtr const& first,
 {
     OutputPtr recent_output;
 
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         if (output == first) {
             continue;
         }
@@ -383,7 +383,7 @@ void Generator::line_up(OutputPtr const& first,
 
 void Generator::replicate_impl(const ConfigPtr& config)
 {
-    auto outputs = config->outputs();
+    auto const& outputs = config->output_map();
     auto source = primary_impl(outputs, OutputMap());
 
     if (config->supported_features().testFlag(Config::Feature::PrimaryDisplay)) {
@@ -399,7 +399,7 @@ void Generator::replicate_impl(const ConfigPtr& config)
     qCDebug(DISMAN) << "Generate multi-output config by replicating" << source << "on"
                     << outputs.size() - 1 << "other outputs.";
 
-    for (auto& [key, output] : outputs) {
+    for (auto const& [key, output] : outputs) {
         if (output == source) {
             continue;
         }
@@ -424,7 +424,7 @@ ConfigPtr Generator::multi_output_fallback(ConfigPtr const& config)
 bool Generator::check_config(ConfigPtr const& config)
 {
     int enabled = 0;
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         enabled += output->enabled();
     }
     if (m_validities & Config::ValidityFlag::RequireAtLeastOneEnabledScreen && enabled == 0) {
@@ -438,17 +438,17 @@ bool Generator::check_config(ConfigPtr const& config)
 
 OutputPtr Generator::primary(OutputMap const& exclusions) const
 {
-    return primary_impl(m_config->outputs(), exclusions);
+    return primary_impl(m_config->output_map(), exclusions);
 }
 
 OutputPtr Generator::embedded() const
 {
-    return embedded_impl(m_config->outputs(), OutputMap());
+    return embedded_impl(m_config->output_map(), OutputMap());
 }
 
 OutputPtr Generator::biggest(OutputMap const& exclusions) const
 {
-    return biggest_impl(m_config->outputs(), false, exclusions);
+    return biggest_impl(m_config->output_map(), false, exclusions);
 }
 
 OutputPtr Generator::primary_impl(OutputMap const& outputs, OutputMap const& exclusions) const
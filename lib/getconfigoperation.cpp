@@ -38,13 +38,16 @@ public:
     GetConfigOperationPrivate(GetConfigOperation* qq);
 
     void backend_ready(org::kwinft::disman::backend* backend) override;
+    void onBinaryConfigReceived(QDBusPendingCallWatcher* watcher);
     void onConfigReceived(QDBusPendingCallWatcher* watcher);
 
 public:
     ConfigPtr config;
+    GetConfigOperation::Options options;
 
     // For out-of-process
     QPointer<org::kwinft::disman::backend> mBackend;
+    BackendManager::ConfigStamp config_stamp;
 
 private:
     Q_DECLARE_PUBLIC(GetConfigOperation)
@@ -71,11 +74,45 @@ void GetConfigOperationPrivate::backend_ready(org::kwinft::disman::backend* back
     }
 
     mBackend = backend;
-    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(mBackend->getConfig(), this);
+    config_stamp = BackendManager::instance()->config_stamp();
+    QDBusPendingCallWatcher* watcher
+        = new QDBusPendingCallWatcher(mBackend->getConfigBinary(), this);
     connect(watcher,
             &QDBusPendingCallWatcher::finished,
             this,
-            &GetConfigOperationPrivate::onConfigReceived);
+            &GetConfigOperationPrivate::onBinaryConfigReceived);
+}
+
+void GetConfigOperationPrivate::onBinaryConfigReceived(QDBusPendingCallWatcher* watcher)
+{
+    Q_ASSERT(BackendManager::instance()->method() == BackendManager::OutOfProcess);
+    Q_Q(GetConfigOperation);
+
+    QDBusPendingReply<QByteArray> reply = *watcher;
+    watcher->deleteLater();
+    if (reply.isError()) {
+        if (reply.error().type() == QDBusError::UnknownMethod && mBackend) {
+            // Launcher from before the binary format was introduced.
+            auto legacy_watcher = new QDBusPendingCallWatcher(mBackend->getConfig(), this);
+            connect(legacy_watcher,
+                    &QDBusPendingCallWatcher::finished,
+                    this,
+                    &GetConfigOperationPrivate::onConfigReceived);
+            return;
+        }
+        q->set_error(reply.error().message());
+        q->emit_result();
+        return;
+    }
+
+    config = ConfigSerializer::deserialize_config_binary(reply.value());
+    if (!config) {
+        q->set_error(tr("Failed to deserialize backend response"));
+    } else {
+        BackendManager::instance()->update_cached_config(config, config_stamp);
+    }
+
+    q->emit_result();
 }
 
 void GetConfigOperationPrivate::onConfigReceived(QDBusPendingCallWatcher* watcher)
@@ -83,7 +120,7 @@ void GetConfigOperationPrivate::onConfigReceived(QDBusPendingCallWatcher* watche
     Q_ASSERT(BackendManager::instance()->method() == BackendManager::OutOfProcess);
     Q_Q(GetConfigOperation);
 
-    QDBusPendingReply<QVariantMap> reply = *watcher;
+    QDBusPendingReply<ConfigSerializer::DBusConfig> reply = *watcher;
     watcher->deleteLater();
     if (reply.isError()) {
         q->set_error(reply.error().message());
@@ -91,17 +128,26 @@ void GetConfigOperationPrivate::onConfigReceived(QDBusPendingCallWatcher* watche
         return;
     }
 
-    config = ConfigSerializer::deserialize_config(reply.value());
+    config = reply.value().config;
     if (!config) {
         q->set_error(tr("Failed to deserialize backend response"));
+    } else {
+        BackendManager::instance()->update_cached_config(config, config_stamp);
     }
 
     q->emit_result();
 }
 
 GetConfigOperation::GetConfigOperation(QObject* parent)
+    : GetConfigOperation(Option::None, parent)
+{
+}
+
+GetConfigOperation::GetConfigOperation(Options options, QObject* parent)
     : ConfigOperation(new GetConfigOperationPrivate(this), parent)
 {
+    Q_D(GetConfigOperation);
+    d->options = options;
 }
 
 GetConfigOperation::~GetConfigOperation()
@@ -125,6 +171,13 @@ void GetConfigOperation::start()
         d->config = backend->config()->clone();
         emit_result();
     } else {
+        if (!d->options.testFlag(Option::NoCache)) {
+            if (auto cached = BackendManager::instance()->cached_config()) {
+                d->config = cached->clone();
+                emit_result();
+                return;
+            }
+        }
         d->request_backend();
     }
 }
@@ -33,7 +33,18 @@ class DISMAN_EXPORT GetConfigOperation : public Disman::ConfigOperation
     Q_OBJECT
 
 public:
+    enum class Option {
+        None = 0,
+        /**
+         * Always request the config from the backend. Otherwise the last config announced by the
+         * backend is used when no change is pending since then.
+         */
+        NoCache = 1,
+    };
+    Q_DECLARE_FLAGS(Options, Option)
+
     explicit GetConfigOperation(QObject* parent = nullptr);
+    explicit GetConfigOperation(Options options, QObject* parent = nullptr);
     ~GetConfigOperation() override;
 
     Disman::ConfigPtr config() const override;
@@ -46,4 +57,6 @@ private:
 };
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Disman::GetConfigOperation::Options)
+
 #endif
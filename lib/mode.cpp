@@ -17,11 +17,15 @@
  *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA       *
  *************************************************************************************/
 #include "mode.h"
+#include "mode_p.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace Disman
 {
 
-class Q_DECL_HIDDEN Mode::Private
+class Q_DECL_HIDDEN Mode::Private : public QSharedData
 {
 public:
     Private()
@@ -30,19 +34,44 @@ public:
     }
 
     Private(const Private& other)
-        : id(other.id)
+        : QSharedData(other)
+        , id(other.id)
         , name(other.name)
         , size(other.size)
         , rate(other.rate)
+        , observers(other.observers)
     {
     }
 
+    void notify()
+    {
+        for (auto const& observer : observers) {
+            if (auto version = observer.lock()) {
+                ++*version;
+            }
+        }
+    }
+
     std::string id;
     std::string name;
     QSize size;
     int rate;
+
+    // Version counters of the mode tables the mode was handed out from. Data shared with clones
+    // notifies the tables of all of them, what at worst makes a table check its modes again.
+    mutable std::vector<std::weak_ptr<uint64_t>> observers;
 };
 
+void observe_mode(Mode const& mode, std::shared_ptr<uint64_t> const& version)
+{
+    auto& observers = mode.d.constData()->observers;
+    observers.erase(std::remove_if(observers.begin(),
+                                   observers.end(),
+                                   [](auto const& observer) { return observer.expired(); }),
+                    observers.end());
+    observers.push_back(version);
+}
+
 Mode::Mode()
     : d(new Private())
 {
@@ -53,14 +82,11 @@ Mode::Mode(Mode::Private* dd)
 {
 }
 
-Mode::~Mode()
-{
-    delete d;
-}
+Mode::~Mode() = default;
 
 ModePtr Mode::clone() const
 {
-    return ModePtr(new Mode(new Private(*d)));
+    return ModePtr(new Mode(const_cast<Private*>(d.constData())));
 }
 
 std::string Mode::id() const
@@ -70,11 +96,12 @@ std::string Mode::id() const
 
 void Mode::set_id(std::string const& id)
 {
-    if (d->id == id) {
+    if (d.constData()->id == id) {
         return;
     }
 
     d->id = id;
+    d->notify();
 }
 
 std::string Mode::name() const
@@ -84,11 +111,12 @@ std::string Mode::name() const
 
 void Mode::set_name(std::string const& name)
 {
-    if (d->name == name) {
+    if (d.constData()->name == name) {
         return;
     }
 
     d->name = name;
+    d->notify();
 }
 
 QSize Mode::size() const
@@ -98,11 +126,12 @@ QSize Mode::size() const
 
 void Mode::set_size(const QSize& size)
 {
-    if (d->size == size) {
+    if (d.constData()->size == size) {
         return;
     }
 
     d->size = size;
+    d->notify();
 }
 
 int Mode::refresh() const
@@ -112,11 +141,12 @@ int Mode::refresh() const
 
 void Mode::set_refresh(int refresh)
 {
-    if (d->rate == refresh) {
+    if (d.constData()->rate == refresh) {
         return;
     }
 
     d->rate = refresh;
+    d->notify();
 }
 
 }
@@ -23,6 +23,7 @@
 #include "types.h"
 
 #include <QDebug>
+#include <QSharedDataPointer>
 #include <QSize>
 #include <string>
 
@@ -35,6 +36,10 @@ public:
     Mode();
     ~Mode();
 
+    /**
+     * The returned mode shares its data with this one until either of them is changed. Cloning
+     * is therefore cheap and does not copy the mode's id and name.
+     */
     ModePtr clone() const;
 
     std::string id() const;
@@ -53,9 +58,11 @@ private:
     Q_DISABLE_COPY(Mode)
 
     class Private;
-    Private* const d;
+    QSharedDataPointer<Private> d;
 
     Mode(Private* dd);
+
+    friend void observe_mode(Mode const& mode, std::shared_ptr<uint64_t> const& version);
 };
 
 }
@@ -0,0 +1,23 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace Disman
+{
+
+class Mode;
+
+/**
+ * Makes every change to the data of @p mode increase @p version. Mode tables use this to find out
+ * if modes that were handed out have been changed since some point in time. The counter is only
+ * referenced weakly, so it is released together with the table.
+ */
+void observe_mode(Mode const& mode, std::shared_ptr<uint64_t> const& version);
+
+}
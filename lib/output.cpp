@@ -21,6 +21,7 @@
 
 #include "disman_debug.h"
 #include "mode.h"
+#include "mode_p.h"
 
 #include <QCryptographicHash>
 #include <QRect>
@@ -33,6 +34,7 @@ namespace Disman
 Output::Private::Private()
     : id(0)
     , type(Unknown)
+    , mode_table(std::make_shared<ModeTable>())
     , replication_source(0)
     , rotation(None)
     , scale(1.0)
@@ -46,6 +48,7 @@ Output::Private::Private(const Private& other)
     , description(other.description)
     , hash(other.hash)
     , type(other.type)
+    , mode_table(other.shared_modes())
     , replication_source(other.replication_source)
     , resolution(other.resolution)
     , refresh_rate(other.refresh_rate)
@@ -66,21 +69,197 @@ Output::Private::Private(const Private& other)
     , retention{other.retention}
     , global{other.global}
 {
-    for (auto const& [key, otherMode] : other.modeList) {
-        modeList.insert({key, otherMode->clone()});
+}
+
+std::shared_ptr<Output::Private::ModeTable> Output::Private::clone_mode_table(ModeMap const& modes)
+{
+    // Only the mode objects are created anew. Their data is still shared.
+    auto table = std::make_shared<ModeTable>();
+    for (auto const& [key, mode] : modes) {
+        table->modes.insert({key, mode->clone()});
     }
+    table->build_index();
+    return table;
 }
 
-ModePtr Output::Private::mode(QSize const& resolution, int refresh) const
+std::shared_ptr<Output::Private::ModeTable> Output::Private::shared_modes() const
+{
+    if (mode_table->exposed) {
+        return clone_mode_table(mode_table->modes);
+    }
+    return mode_table;
+}
+
+void Output::Private::set_modes(ModeMap const& modes)
 {
-    for (auto const& [key, mode] : modeList) {
-        if (resolution == mode->size() && refresh == mode->refresh()) {
-            return mode;
+    // The caller holds the modes already so they count as exposed.
+    mode_table = std::make_shared<ModeTable>();
+    mode_table->modes = modes;
+    mode_table->expose();
+    mode_table->build_index();
+}
+
+ModeMap const& Output::Private::modes() const
+{
+    return mode_table->modes;
+}
+
+ModeMap const& Output::Private::exposed_modes() const
+{
+    if (!mode_table->exposed) {
+        if (mode_table.use_count() > 1) {
+            mode_table = clone_mode_table(mode_table->modes);
         }
+        mode_table->expose();
     }
+    return mode_table->modes;
+}
+
+ModePtr Output::Private::expose(ModePtr const& mode) const
+{
+    if (!mode || mode_table->exposed) {
+        return mode;
+    }
+    if (mode_table.use_count() == 1) {
+        mode_table->expose();
+        return mode;
+    }
+
+    auto const shared_table = mode_table;
+    exposed_modes();
+
+    for (auto const& [key, shared_mode] : shared_table->modes) {
+        if (shared_mode == mode) {
+            return mode_table->modes.at(key);
+        }
+    }
+
+    Q_ASSERT_X(false, "expose", "mode must be in mode table");
     return ModePtr();
 }
 
+void Output::Private::ModeTable::expose()
+{
+    if (exposed) {
+        return;
+    }
+    exposed = true;
+    version = std::make_shared<uint64_t>(0);
+    for (auto const& [key, mode] : modes) {
+        observe_mode(*mode, version);
+    }
+}
+
+uint64_t Output::Private::ModeTable::current_version() const
+{
+    return version ? *version : 0;
+}
+
+ModePtr Output::Private::ModeTable::find(QSize const& resolution, int refresh)
+{
+    if (index_version != current_version()) {
+        build_index();
+    }
+
+    auto const mode = index.find({resolution.width(), resolution.height(), refresh});
+    if (mode == index.end()) {
+        return ModePtr();
+    }
+    return mode->second;
+}
+
+void Output::Private::ModeTable::build_index()
+{
+    index.clear();
+
+    // Multiple modes can have the same resolution and refresh rate. The first one wins.
+    for (auto const& [key, mode] : modes) {
+        auto const size = mode->size();
+        index.insert({{size.width(), size.height(), mode->refresh()}, mode});
+    }
+    index_version = current_version();
+}
+
+uint64_t Output::Private::ModeTable::fingerprint()
+{
+    if (fingerprint_valid && fingerprint_version == current_version()) {
+        return fingerprint_value;
+    }
+
+    // 64-bit FNV-1a. Strings are terminated by a zero byte, integers are added byte by byte.
+    uint64_t fnv = 0xcbf29ce484222325;
+    auto const add_byte = [&fnv](unsigned char byte) {
+        fnv ^= byte;
+        fnv *= 0x100000001b3;
+    };
+    auto const add_string = [&add_byte](std::string const& str) {
+        for (auto byte : str) {
+            add_byte(static_cast<unsigned char>(byte));
+        }
+        add_byte(0);
+    };
+    auto const add_int = [&add_byte](int value) {
+        auto const bits = static_cast<uint32_t>(value);
+        for (int shift = 0; shift < 32; shift += 8) {
+            add_byte(static_cast<unsigned char>(bits >> shift));
+        }
+    };
+
+    for (auto const& [key, mode] : modes) {
+        add_string(key);
+        add_string(mode->name());
+        add_int(mode->size().width());
+        add_int(mode->size().height());
+        add_int(mode->refresh());
+    }
+
+    fingerprint_value = fnv;
+    fingerprint_version = current_version();
+    fingerprint_valid = true;
+    return fingerprint_value;
+}
+
+ModePtr Output::Private::mode(QSize const& resolution, int refresh) const
+{
+    return mode_table->find(resolution, refresh);
+}
+
+ModePtr Output::Private::auto_mode() const
+{
+    // Pick the preferred mode if the resolution and refresh rate is set to auto.
+    // Picking the highest one causes issues for monitors that advertise preferred modes lower
+    // than the highest available monitor (best example would be a 640x480 CRT that
+    // exposes a 800x600 mode, but there's also a gaming monitor that gives a preferred
+    // 144Hz mode, but exposes a 165Hz mode when "overclocking")
+    if (auto_resolution && auto_refresh_rate) {
+        return preferred_mode();
+    }
+    auto const mode_resolution = auto_resolution ? best_resolution(modes()) : resolution;
+    auto const mode_refresh_rate
+        = auto_refresh_rate ? best_refresh_rate(modes(), mode_resolution) : refresh_rate;
+
+    if (auto match = mode(mode_resolution, mode_refresh_rate)) {
+        return match;
+    }
+    return preferred_mode();
+}
+
+ModePtr Output::Private::preferred_mode() const
+{
+    if (!preferredMode.empty()) {
+        return modes().at(preferredMode);
+    }
+    if (preferred_modes.empty()) {
+        return best_mode(modes());
+    }
+
+    auto best = best_mode(preferred_modes);
+    Q_ASSERT_X(best, "preferred_mode", "biggest mode must exist");
+
+    preferredMode = best->id();
+    return best;
+}
+
 bool Output::Private::compareModeMap(const ModeMap& before, const ModeMap& after)
 {
     if (before.size() != after.size()) {
@@ -234,12 +413,16 @@ std::string Output::hash() const
 void Output::set_hash(std::string const& input)
 {
     auto const hash = QCryptographicHash::hash(input.c_str(), QCryptographicHash::Md5);
-    d->hash = QString::fromLatin1(hash.toHex()).toStdString();
+    set_hash_raw(QString::fromLatin1(hash.toHex()).toStdString());
 }
 
 void Output::set_hash_raw(std::string const& hash)
 {
+    if (d->hash == hash) {
+        return;
+    }
     d->hash = hash;
+    Q_EMIT hash_changed();
 }
 
 Output::Type Output::type() const
@@ -254,32 +437,36 @@ void Output::setType(Type type)
 
 ModePtr Output::mode(std::string const& id) const
 {
-    if (d->modeList.find(id) == d->modeList.end()) {
-        return ModePtr();
+    auto const& modes = d->modes();
+    if (auto mode = modes.find(id); mode != modes.end()) {
+        return d->expose(mode->second);
     }
-
-    return d->modeList[id];
+    return ModePtr();
 }
 
 ModePtr Output::mode(QSize const& resolution, int refresh) const
 {
-    for (auto const& [key, mode] : d->modeList) {
-        if (mode->size() == resolution && mode->refresh() == refresh) {
-            return mode;
-        }
-    }
-
-    return {};
+    return d->expose(d->mode(resolution, refresh));
 }
 
 ModeMap Output::modes() const
 {
-    return d->modeList;
+    return d->exposed_modes();
+}
+
+ModeMapView Output::mode_map() const
+{
+    return ModeMapView(d->modes());
+}
+
+uint64_t Output::modes_fingerprint() const
+{
+    return d->mode_table->fingerprint();
 }
 
 void Output::set_modes(const ModeMap& modes)
 {
-    d->modeList = modes;
+    d->set_modes(modes);
 }
 
 void Output::set_mode(ModePtr const& mode)
@@ -295,58 +482,39 @@ void Output::set_to_preferred_mode()
 
 ModePtr Output::commanded_mode() const
 {
-    for (auto const& [key, mode] : d->modeList) {
-        if (mode->size() == d->resolution && mode->refresh() == d->refresh_rate) {
-            return mode;
-        }
-    }
-    return ModePtr();
+    return d->expose(d->mode(d->resolution, d->refresh_rate));
 }
 
 bool Output::set_resolution(QSize const& size)
 {
     d->resolution = size;
-    return commanded_mode() != nullptr;
+    return d->mode(d->resolution, d->refresh_rate) != nullptr;
 }
 
 bool Output::set_refresh_rate(int rate)
 {
     d->refresh_rate = rate;
-    return commanded_mode() != nullptr;
+    return d->mode(d->resolution, d->refresh_rate) != nullptr;
 }
 
 QSize Output::best_resolution() const
 {
-    return d->best_resolution(modes());
+    return d->best_resolution(d->modes());
 }
 
 int Output::best_refresh_rate(QSize const& resolution) const
 {
-    return d->best_refresh_rate(modes(), resolution);
+    return d->best_refresh_rate(d->modes(), resolution);
 }
 
 ModePtr Output::best_mode() const
 {
-    return d->best_mode(modes());
+    return d->expose(d->best_mode(d->modes()));
 }
 
 ModePtr Output::auto_mode() const
 {
-    // Pick the preferred mode if the resolution and refresh rate is set to auto.
-    // Picking the highest one causes issues for monitors that advertise preferred modes lower
-    // than the highest available monitor (best example would be a 640x480 CRT that
-    // exposes a 800x600 mode, but there's also a gaming monitor that gives a preferred
-    // 144Hz mode, but exposes a 165Hz mode when "overclocking")
-    if (auto_resolution() && auto_refresh_rate()) {
-        return preferred_mode();
-    }
-    auto const resolution = auto_resolution() ? best_resolution() : d->resolution;
-    auto const refresh_rate = auto_refresh_rate() ? best_refresh_rate(resolution) : d->refresh_rate;
-
-    if (auto mode = d->mode(resolution, refresh_rate)) {
-        return mode;
-    }
-    return preferred_mode();
+    return d->expose(d->auto_mode());
 }
 
 void Output::set_preferred_modes(std::vector<std::string> const& modes)
@@ -362,18 +530,7 @@ std::vector<std::string> const& Output::preferred_modes() const
 
 ModePtr Output::preferred_mode() const
 {
-    if (!d->preferredMode.empty()) {
-        return d->modeList.at(d->preferredMode);
-    }
-    if (d->preferred_modes.empty()) {
-        return d->best_mode(modes());
-    }
-
-    auto best = d->best_mode(d->preferred_modes);
-    Q_ASSERT_X(best, "preferred_mode", "biggest mode must exist");
-
-    d->preferredMode = best->id();
-    return best;
+    return d->expose(d->preferred_mode());
 }
 
 void Output::set_position(const QPointF& position)
@@ -411,7 +568,7 @@ QRectF Output::geometry() const
         return d->enforced_geometry;
     }
 
-    auto const mode = auto_mode();
+    auto const mode = d->auto_mode();
     if (!mode) {
         return geo;
     }
@@ -567,7 +724,7 @@ void Output::apply(const OutputPtr& other)
 {
     set_name(other->d->name);
     set_description(other->d->description);
-    d->hash = other->d->hash;
+    set_hash_raw(other->d->hash);
     setType(other->d->type);
     set_position(other->geometry().topLeft());
     set_rotation(other->d->rotation);
@@ -577,11 +734,7 @@ void Output::apply(const OutputPtr& other)
     set_replication_source(other->d->replication_source);
 
     set_preferred_modes(other->d->preferred_modes);
-    ModeMap modes;
-    for (auto const& [key, mode] : other->modes()) {
-        modes.insert({key, mode->clone()});
-    }
-    set_modes(modes);
+    d->mode_table = other->d->shared_modes();
 
     set_resolution(other->d->resolution);
     set_refresh_rate(other->d->refresh_rate);
@@ -690,7 +843,7 @@ std::string Output::log() const
     std::stringstream ss;
 
     ss << "Output " << id() << ", " << description() << " (" << name() << ")" << std::endl
-       << gap << "mode: " << stream_mode(auto_mode()) << std::endl
+       << gap << "mode: " << stream_mode(d->auto_mode()) << std::endl
        << gap << "adapt sync: " << (adaptive_sync() ? "yes" : "no")
        << " (supports toggle: " << (adaptive_sync_toggle_support() ? "yes" : "no") << ")"
        << std::endl
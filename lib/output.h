@@ -30,11 +30,78 @@
 #include <QPoint>
 #include <QSize>
 
+#include <cstdint>
 #include <string>
+#include <utility>
 
 namespace Disman
 {
 
+/**
+ * Read-only view of the modes of an output. Iterating it neither copies the map nor the modes. The
+ * modes might be shared with clones of the output, so they are only handed out as const.
+ */
+class ModeMapView
+{
+public:
+    class const_iterator
+    {
+    public:
+        using value_type = std::pair<std::string const&, std::shared_ptr<Mode const>>;
+
+        explicit const_iterator(ModeMap::const_iterator it)
+            : m_it{it}
+        {
+        }
+
+        value_type operator*() const
+        {
+            return {m_it->first, m_it->second};
+        }
+        const_iterator& operator++()
+        {
+            ++m_it;
+            return *this;
+        }
+        bool operator==(const_iterator const& other) const
+        {
+            return m_it == other.m_it;
+        }
+        bool operator!=(const_iterator const& other) const
+        {
+            return m_it != other.m_it;
+        }
+
+    private:
+        ModeMap::const_iterator m_it;
+    };
+
+    explicit ModeMapView(ModeMap const& modes)
+        : m_modes{modes}
+    {
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(m_modes.cbegin());
+    }
+    const_iterator end() const
+    {
+        return const_iterator(m_modes.cend());
+    }
+    size_t size() const
+    {
+        return m_modes.size();
+    }
+    bool empty() const
+    {
+        return m_modes.empty();
+    }
+
+private:
+    ModeMap const& m_modes;
+};
+
 class DISMAN_EXPORT Output : public QObject
 {
     Q_OBJECT
@@ -130,8 +197,20 @@ public:
     ModePtr mode(QSize const& resolution, int refresh) const;
 
     ModeMap modes() const;
+
+    /**
+     * Same as modes() but without copying the map or the modes. Use modes() to change them. The
+     * view stays valid until the modes of the output are replaced with set_modes() or apply().
+     */
+    ModeMapView mode_map() const;
     void set_modes(const ModeMap& modes);
 
+    /**
+     * Fingerprint of the ids and data of all modes. Outputs with the same fingerprint have the
+     * same modes. Used to avoid sending mode lists that the receiver already knows.
+     */
+    uint64_t modes_fingerprint() const;
+
     /**
      * Sets the mode.
      *
@@ -328,6 +407,11 @@ Q_SIGNALS:
      */
     void updated();
 
+    /**
+     * The identifying hash of the output changed.
+     */
+    void hash_changed();
+
 private:
     Q_DISABLE_COPY(Output)
 
@@ -336,6 +420,7 @@ private:
 
     Output(Private* dd);
 
+    friend class ConfigDiff;
     friend class Generator;
 };
 
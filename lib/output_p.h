@@ -23,6 +23,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <QRectF>
 #include <QScopedPointer>
 
+#include <map>
+#include <memory>
+#include <tuple>
+
 namespace Disman
 {
 
@@ -32,7 +36,54 @@ public:
     Private();
     Private(const Private& other);
 
+    /**
+     * Modes of an output. The table is shared between an output and its clones as long as none of
+     * its modes have been handed out through the public API, where they could be modified. Once
+     * that happened the table is marked as exposed and is not shared anymore.
+     */
+    struct ModeTable {
+        /**
+         * Looks up the first mode in the table with @param resolution and @param refresh rate.
+         * The index is rebuilt first in case handed out modes have been changed.
+         */
+        ModePtr find(QSize const& resolution, int refresh);
+        void build_index();
+
+        /**
+         * Like the index the fingerprint is recomputed when handed out modes have been changed.
+         */
+        uint64_t fingerprint();
+
+        /**
+         * Marks the table as exposed. From then on changes to its modes increase its version.
+         */
+        void expose();
+        uint64_t current_version() const;
+
+        ModeMap modes;
+        bool exposed{false};
+        std::shared_ptr<uint64_t> version;
+
+        std::map<std::tuple<int, int, int>, ModePtr> index;
+        uint64_t index_version{0};
+
+        uint64_t fingerprint_value{0};
+        uint64_t fingerprint_version{0};
+        bool fingerprint_valid{false};
+    };
+
+    static std::shared_ptr<ModeTable> clone_mode_table(ModeMap const& modes);
+
+    std::shared_ptr<ModeTable> shared_modes() const;
+    void set_modes(ModeMap const& modes);
+
+    ModeMap const& modes() const;
+    ModeMap const& exposed_modes() const;
+    ModePtr expose(ModePtr const& mode) const;
+
     ModePtr mode(QSize const& resolution, int refresh_rate) const;
+    ModePtr auto_mode() const;
+    ModePtr preferred_mode() const;
 
     template<typename M>
     ModePtr get_mode(M const& mode) const
@@ -84,7 +135,7 @@ public:
         return mode(resolution, refresh_rate);
     }
 
-    bool compareModeMap(const ModeMap& before, const ModeMap& after);
+    static bool compareModeMap(const ModeMap& before, const ModeMap& after);
     void apply_global();
 
     int id;
@@ -92,14 +143,14 @@ public:
     std::string description;
     std::string hash;
     Type type;
-    ModeMap modeList;
+    mutable std::shared_ptr<ModeTable> mode_table;
     int replication_source;
 
     QSize resolution;
     int refresh_rate{0};
     bool adapt_sync{false};
 
-    std::string preferredMode;
+    mutable std::string preferredMode;
     std::vector<std::string> preferred_modes;
     QSize physical_size;
     QPointF position;
@@ -123,7 +174,7 @@ public:
 template<>
 inline ModePtr Output::Private::get_mode(std::string const& modeId) const
 {
-    if (auto mode = modeList.find(modeId); mode != modeList.end()) {
+    if (auto mode = modes().find(modeId); mode != modes().end()) {
         return mode->second;
     }
     return ModePtr();
@@ -42,11 +42,15 @@ public:
     explicit SetConfigOperationPrivate(const Disman::ConfigPtr& config, ConfigOperation* qq);
 
     void backend_ready(org::kwinft::disman::backend* backend) override;
+    void onBinaryConfigSet(QDBusPendingCallWatcher* watcher);
     void onConfigSet(QDBusPendingCallWatcher* watcher);
     void normalizeOutputPositions();
 
     Disman::ConfigPtr config;
 
+    // For out-of-process
+    QPointer<org::kwinft::disman::backend> mBackend;
+
 private:
     Q_DECLARE_PUBLIC(SetConfigOperation)
 };
@@ -71,23 +75,62 @@ void SetConfigOperationPrivate::backend_ready(org::kwinft::disman::backend* back
         return;
     }
 
-    const QVariantMap map = ConfigSerializer::serialize_config(config).toVariantMap();
-    if (map.isEmpty()) {
+    auto const data = ConfigSerializer::serialize_config_binary(config);
+    if (data.isEmpty()) {
         q->set_error(tr("Failed to serialize request"));
         q->emit_result();
         return;
     }
 
-    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(backend->setConfig(map), this);
-    connect(
-        watcher, &QDBusPendingCallWatcher::finished, this, &SetConfigOperationPrivate::onConfigSet);
+    // The backend config changes now, the cache is only valid again after the change has been
+    // announced.
+    BackendManager::instance()->invalidate_cached_config();
+
+    mBackend = backend;
+    QDBusPendingCallWatcher* watcher
+        = new QDBusPendingCallWatcher(backend->setConfigBinary(data), this);
+    connect(watcher,
+            &QDBusPendingCallWatcher::finished,
+            this,
+            &SetConfigOperationPrivate::onBinaryConfigSet);
+}
+
+void SetConfigOperationPrivate::onBinaryConfigSet(QDBusPendingCallWatcher* watcher)
+{
+    Q_Q(SetConfigOperation);
+
+    QDBusPendingReply<QByteArray> reply = *watcher;
+    watcher->deleteLater();
+
+    if (reply.isError()) {
+        if (reply.error().type() == QDBusError::UnknownMethod && mBackend) {
+            // Launcher from before the binary format was introduced.
+            auto legacy_watcher
+                = new QDBusPendingCallWatcher(mBackend->setConfig({config}), this);
+            connect(legacy_watcher,
+                    &QDBusPendingCallWatcher::finished,
+                    this,
+                    &SetConfigOperationPrivate::onConfigSet);
+            return;
+        }
+        q->set_error(reply.error().message());
+        q->emit_result();
+        return;
+    }
+
+    config = ConfigSerializer::deserialize_config_binary(reply.value());
+    if (!config) {
+        q->set_error(tr("Failed to deserialize backend response"));
+    }
+
+    q->emit_result();
 }
 
 void SetConfigOperationPrivate::onConfigSet(QDBusPendingCallWatcher* watcher)
 {
     Q_Q(SetConfigOperation);
 
-    QDBusPendingReply<QVariantMap> reply = *watcher;
+    QDBusPendingReply<ConfigSerializer::DBusConfig> reply = *watcher;
     watcher->deleteLater();
 
     if (reply.isError()) {
@@ -96,7 +139,7 @@ void SetConfigOperationPrivate::onConfigSet(QDBusPendingCallWatcher* watcher)
         return;
     }
 
-    config = ConfigSerializer::deserialize_config(reply.value());
+    config = reply.value().config;
     if (!config) {
         q->set_error(tr("Failed to deserialize backend response"));
     }
@@ -139,7 +182,7 @@ void SetConfigOperationPrivate::normalizeOutputPositions()
     }
     double offsetX = INT_MAX;
     double offsetY = INT_MAX;
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         if (!output->positionable()) {
             continue;
         }
@@ -151,7 +194,7 @@ void SetConfigOperationPrivate::normalizeOutputPositions()
         return;
     }
     qCDebug(DISMAN) << "Correcting output positions by:" << QPoint(offsetX, offsetY);
-    for (auto const& [key, output] : config->outputs()) {
+    for (auto const& [key, output] : config->output_map()) {
         if (!output->enabled()) {
             continue;
         }
@@ -23,15 +23,23 @@
 
 #include "backend.h"
 #include "config.h"
+#include "configdiff.h"
 #include "configserializer_p.h"
+#include "output.h"
 
 #include <QDBusConnection>
 #include <QDBusError>
+#include <QDBusMessage>
+
+#include <algorithm>
 
 BackendDBusWrapper::BackendDBusWrapper(Disman::Backend* backend)
     : QObject()
+    , QDBusContext()
     , mBackend(backend)
 {
+    Disman::ConfigSerializer::register_dbus_types();
+
     connect(mBackend,
             &Disman::Backend::config_changed,
             this,
@@ -41,6 +49,17 @@ BackendDBusWrapper::BackendDBusWrapper(Disman::Backend* backend)
     mChangeCollector.setInterval(200); // wait for 200 msecs without any change
                                        // before actually emitting configChanged
     connect(&mChangeCollector, &QTimer::timeout, this, &BackendDBusWrapper::doEmitConfigChanged);
+
+    mClientWatcher.setConnection(QDBusConnection::sessionBus());
+    mClientWatcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(&mClientWatcher,
+            &QDBusServiceWatcher::serviceUnregistered,
+            this,
+            [this](const QString& service) {
+                mClientWatcher.removeWatchedService(service);
+                mSubscribers.erase(service);
+                mLegacyClients.erase(service);
+            });
 }
 
 BackendDBusWrapper::~BackendDBusWrapper()
@@ -58,40 +77,120 @@ bool BackendDBusWrapper::init()
         return false;
     }
 
+    if (auto config = mBackend->config()) {
+        mEmittedConfig = config->clone();
+        if (!mSharedConfig.publish(mEmittedConfig, mGeneration)) {
+            qCDebug(DISMAN_BACKEND_LAUNCHER) << "Config is not published in shared memory.";
+        }
+    }
+
+    return true;
+}
+
+Disman::ConfigSerializer::DBusConfig BackendDBusWrapper::getConfig()
+{
+    addLegacyClient();
+
+    auto const config = mBackend->config();
+    assert(config != nullptr);
+    if (!config) {
+        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Backend provided an empty config!";
+    }
+
+    return {config};
+}
+
+qulonglong
+BackendDBusWrapper::getConfigSnapshot(Disman::ConfigSerializer::DBusConfig& config) const
+{
+    if (!mEmittedConfig) {
+        qCWarning(DISMAN_BACKEND_LAUNCHER) << "No config snapshot available.";
+    }
+
+    config.config = mEmittedConfig;
+    return mGeneration;
+}
+
+QDBusUnixFileDescriptor BackendDBusWrapper::getConfigSharedMemory() const
+{
+    if (mSharedConfig.fd() < 0) {
+        sendErrorReply(QDBusError::NotSupported,
+                       QStringLiteral("Config is not published in shared memory"));
+        return QDBusUnixFileDescriptor();
+    }
+
+    // The descriptor is duplicated.
+    return QDBusUnixFileDescriptor(mSharedConfig.fd());
+}
+
+bool BackendDBusWrapper::subscribeConfigChanges(uint version, uint channels)
+{
+    if (version != Disman::ConfigSerializer::compact_config_version || !calledFromDBus()) {
+        return false;
+    }
+
+    auto const service = message().service();
+    if (mSubscribers.find(service) == mSubscribers.end() && !mLegacyClients.count(service)) {
+        mClientWatcher.addWatchedService(service);
+    }
+    mLegacyClients.erase(service);
+
+    // Also when subscribing again the client might not know any mode table anymore.
+    mSubscribers[service] = {channels, {}};
     return true;
 }
 
-QVariantMap BackendDBusWrapper::getConfig() const
+QVariantMap BackendDBusWrapper::collectGarbage(int maxCount, int maxAge)
+{
+    return mBackend->collect_garbage(maxCount, maxAge);
+}
+
+Disman::ConfigSerializer::DBusConfig
+BackendDBusWrapper::setConfig(const Disman::ConfigSerializer::DBusConfig& config)
+{
+    if (!config.config) {
+        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Received an invalid config";
+        return {};
+    }
+
+    addLegacyClient();
+    return {applyConfig(config.config)};
+}
+
+QByteArray BackendDBusWrapper::getConfigBinary() const
 {
     auto const config = mBackend->config();
     assert(config != nullptr);
     if (!config) {
         qCWarning(DISMAN_BACKEND_LAUNCHER) << "Backend provided an empty config!";
-        return QVariantMap();
+        return QByteArray();
     }
 
-    const QJsonObject obj = Disman::ConfigSerializer::serialize_config(mBackend->config());
-    Q_ASSERT(!obj.isEmpty());
-    return obj.toVariantMap();
+    return Disman::ConfigSerializer::serialize_config_binary(config);
 }
 
-QVariantMap BackendDBusWrapper::setConfig(const QVariantMap& configMap)
+QByteArray BackendDBusWrapper::setConfigBinary(const QByteArray& data)
 {
-    if (configMap.isEmpty()) {
-        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Received an empty config map";
-        return QVariantMap();
+    auto const config = Disman::ConfigSerializer::deserialize_config_binary(data);
+    if (!config) {
+        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Received an invalid binary config";
+        return QByteArray();
     }
 
-    const Disman::ConfigPtr config = Disman::ConfigSerializer::deserialize_config(configMap);
+    return Disman::ConfigSerializer::serialize_config_binary(applyConfig(config));
+}
+
+Disman::ConfigPtr BackendDBusWrapper::applyConfig(const Disman::ConfigPtr& config)
+{
+    // Clients must not trust their cached configs until the result is published.
+    mSharedConfig.set_pending(true);
     mBackend->set_config(config);
 
     mCurrentConfig = mBackend->config();
     QMetaObject::invokeMethod(this, "doEmitConfigChanged", Qt::QueuedConnection);
 
     // TODO: set_config should return adjusted config that was actually applied
-    const QJsonObject obj = Disman::ConfigSerializer::serialize_config(mCurrentConfig);
-    Q_ASSERT(!obj.isEmpty());
-    return obj.toVariantMap();
+    return mCurrentConfig;
 }
 
 void BackendDBusWrapper::backendConfigChanged(const Disman::ConfigPtr& config)
@@ -103,6 +202,7 @@ void BackendDBusWrapper::backendConfigChanged(const Disman::ConfigPtr& config)
     }
 
     mCurrentConfig = config;
+    mSharedConfig.set_pending(true);
     mChangeCollector.start();
 }
 
@@ -110,12 +210,95 @@ void BackendDBusWrapper::doEmitConfigChanged()
 {
     assert(mCurrentConfig != nullptr);
     if (!mCurrentConfig) {
+        mSharedConfig.set_pending(false);
         return;
     }
 
-    const QJsonObject obj = Disman::ConfigSerializer::serialize_config(mCurrentConfig);
-    Q_EMIT configChanged(obj.toVariantMap());
+    // Each channel serializes the config anew, so only the ones clients listen to are served.
+    if (!mLegacyClients.empty()) {
+        Q_EMIT configChanged({mCurrentConfig});
+    }
+    emitCompactConfigChanged();
+
+    Disman::ConfigDiff const diff(mEmittedConfig, mCurrentConfig);
+    if (!diff.empty()) {
+        mEmittedConfig = mCurrentConfig->clone();
+        ++mGeneration;
+
+        // Publish before the signals, so woken up clients find the new config.
+        if (!mSharedConfig.publish(mEmittedConfig, mGeneration)) {
+            qCDebug(DISMAN_BACKEND_LAUNCHER) << "Config is not published in shared memory.";
+        }
+        if (hasSubscribers(Disman::ConfigSerializer::delta_channel)) {
+            auto const delta
+                = Disman::ConfigSerializer::serialize_config_delta(mCurrentConfig, diff);
+            Q_EMIT configDelta(mGeneration, delta.toVariantMap());
+        }
+    } else {
+        mSharedConfig.set_pending(false);
+    }
+
+    // Also without changes, such that clients waiting on a set operation know the config is final.
+    Q_EMIT configPublished(mGeneration);
 
     mCurrentConfig.reset();
     mChangeCollector.stop();
 }
+
+void BackendDBusWrapper::addLegacyClient()
+{
+    if (!calledFromDBus()) {
+        return;
+    }
+
+    auto const service = message().service();
+    if (mSubscribers.find(service) != mSubscribers.end()) {
+        return;
+    }
+    if (mLegacyClients.insert(service).second) {
+        mClientWatcher.addWatchedService(service);
+    }
+}
+
+bool BackendDBusWrapper::hasSubscribers(Disman::ConfigSerializer::ConfigChannel channel) const
+{
+    return std::any_of(mSubscribers.cbegin(), mSubscribers.cend(), [channel](auto const& entry) {
+        return entry.second.channels & channel;
+    });
+}
+
+void BackendDBusWrapper::emitCompactConfigChanged()
+{
+    if (!hasSubscribers(Disman::ConfigSerializer::compact_channel)) {
+        return;
+    }
+
+    auto dbus = QDBusConnection::sessionBus();
+
+    std::set<uint64_t> current_mode_tables;
+    for (auto const& [id, output] : mCurrentConfig->output_map()) {
+        current_mode_tables.insert(output->modes_fingerprint());
+    }
+
+    // Each client knows different mode tables, so the signal is sent to each one directly.
+    for (auto& [service, subscriber] : mSubscribers) {
+        if (!(subscriber.channels & Disman::ConfigSerializer::compact_channel)) {
+            continue;
+        }
+
+        auto message
+            = QDBusMessage::createTargetedSignal(service,
+                                                 QStringLiteral("/backend"),
+                                                 QStringLiteral("org.kwinft.disman.backend"),
+                                                 QStringLiteral("configChangedCompact"));
+        message << QVariant::fromValue(Disman::ConfigSerializer::DBusCompactConfig{
+            mCurrentConfig, subscriber.known_mode_tables});
+        if (!dbus.send(message)) {
+            qCWarning(DISMAN_BACKEND_LAUNCHER) << "Failed to send compact config to" << service;
+            continue;
+        }
+
+        // The client only keeps the mode tables of the last config, so the set does not grow.
+        subscriber.known_mode_tables = current_mode_tables;
+    }
+}
@@ -20,9 +20,18 @@
 #ifndef BACKENDDBUSWRAPPER_H
 #define BACKENDDBUSWRAPPER_H
 
+#include <QDBusContext>
+#include <QDBusServiceWatcher>
+#include <QDBusUnixFileDescriptor>
 #include <QObject>
 #include <QTimer>
 
+#include <cstdint>
+#include <map>
+#include <set>
+
+#include "configserializer_p.h"
+#include "configsnapshot_p.h"
 #include "types.h"
 
 namespace Disman
@@ -30,7 +39,7 @@ namespace Disman
 class Backend;
 }
 
-class BackendDBusWrapper : public QObject
+class BackendDBusWrapper : public QObject, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kwinft.disman.backend")
@@ -41,8 +50,37 @@ public:
 
     bool init();
 
-    QVariantMap getConfig() const;
-    QVariantMap setConfig(const QVariantMap& config);
+    Disman::ConfigSerializer::DBusConfig getConfig();
+    Disman::ConfigSerializer::DBusConfig
+    setConfig(const Disman::ConfigSerializer::DBusConfig& config);
+
+    QByteArray getConfigBinary() const;
+    QByteArray setConfigBinary(const QByteArray& config);
+
+    /**
+     * Returns the last config announced via configDelta together with its generation. Clients
+     * use it as the base to apply later deltas on.
+     */
+    qulonglong getConfigSnapshot(Disman::ConfigSerializer::DBusConfig& config) const;
+
+    /**
+     * Returns a read-only descriptor of the shared memory region the last config announced via
+     * configDelta is published in. Whenever the region is updated configPublished is emitted.
+     */
+    QDBusUnixFileDescriptor getConfigSharedMemory() const;
+
+    /**
+     * Sends the change signals in @p channels to the calling client from now on, instead of the
+     * legacy configChanged. In configChangedCompact the mode lists of the outputs in the last one
+     * sent to this client are omitted. Returns false if @p version is not supported.
+     */
+    bool subscribeConfigChanges(uint version, uint channels);
+
+    /**
+     * Removes unused control files in the backend, so pending writes of the backend are not
+     * raced. Negative limits use the defaults of the backend.
+     */
+    QVariantMap collectGarbage(int maxCount, int maxAge);
 
     inline Disman::Backend* backend() const
     {
@@ -50,16 +88,42 @@ public:
     }
 
 Q_SIGNALS:
-    void configChanged(const QVariantMap& config);
+    void configChanged(const Disman::ConfigSerializer::DBusConfig& config);
+    void configDelta(qulonglong generation, const QVariantMap& delta);
+    void configPublished(qulonglong generation);
 
 private Q_SLOTS:
     void backendConfigChanged(const Disman::ConfigPtr& config);
     void doEmitConfigChanged();
 
 private:
+    Disman::ConfigPtr applyConfig(const Disman::ConfigPtr& config);
+    void addLegacyClient();
+    bool hasSubscribers(Disman::ConfigSerializer::ConfigChannel channel) const;
+    void emitCompactConfigChanged();
+
     Disman::Backend* mBackend = nullptr;
     QTimer mChangeCollector;
     Disman::ConfigPtr mCurrentConfig;
+
+    struct Subscriber {
+        uint32_t channels{0};
+        // Mode tables of the outputs in the last configChangedCompact sent to the client.
+        std::set<uint64_t> known_mode_tables;
+    };
+
+    // Clients by their unique bus names. Legacy clients called getConfig or setConfig without
+    // subscribing and receive configChanged.
+    std::map<QString, Subscriber> mSubscribers;
+    std::set<QString> mLegacyClients;
+    QDBusServiceWatcher mClientWatcher;
+
+    // Config at the last emitted generation.
+    Disman::ConfigPtr mEmittedConfig;
+    quint64 mGeneration{0};
+
+    // Holds mEmittedConfig for clients to map.
+    Disman::ConfigSnapshotWriter mSharedConfig;
 };
 
 #endif // BACKENDDBUSWRAPPER_H